@@ -0,0 +1,44 @@
+// Counter-based random numbers, shared by the kernels through #include.
+// Must match Random.h: the same seed, stream and counter give the same
+// values on the CPU and the GPU.
+
+const float RANDOM_TWO_PI = 6.28318530718;
+
+// pcg hash
+uint pcgHash(uint v) {
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+struct RandomStream {
+    uint key;
+    uint counter; // index of the next draw
+};
+
+RandomStream randomStream(uint seed, uint stream) {
+    return RandomStream(pcgHash(seed ^ pcgHash(stream)), 0u);
+}
+
+uint randomUInt(inout RandomStream s) {
+    uint value = pcgHash(s.key + s.counter);
+    s.counter++;
+    return value;
+}
+
+// [0, 1), 24 bits
+float randomFloat(inout RandomStream s) {
+    return float(randomUInt(s) >> 8) / 16777216.0;
+}
+
+// [lo, hi)
+float randomRange(inout RandomStream s, float lo, float hi) {
+    return lo + (hi - lo) * randomFloat(s);
+}
+
+// N(0, 1), uses two draws
+float randomNormal(inout RandomStream s) {
+    float u1 = (float(randomUInt(s) >> 8) + 1.0) / 16777216.0;
+    float u2 = randomFloat(s);
+    return sqrt(-2.0 * log(u1)) * cos(RANDOM_TWO_PI * u2);
+}
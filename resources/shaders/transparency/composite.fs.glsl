@@ -0,0 +1,20 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D accumTexture;
+uniform sampler2D revealageTexture;
+
+// Weighted average of the translucent fragments, blended over the opaque scene
+// with the total coverage, see TransparencyPass
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(revealageTexture, texel, 0).r;
+    if (revealage >= 1.0)
+        discard; // nothing translucent here
+
+    vec4 accum = texelFetch(accumTexture, texel, 0);
+    vec3 average = accum.rgb / clamp(accum.a, 1e-4, 5e4);
+    FragColor = vec4(average, 1.0 - revealage);
+}
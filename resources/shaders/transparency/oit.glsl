@@ -0,0 +1,21 @@
+// Output of translucent fragments into TransparencyPass, shared by their
+// fragment shaders through #include. Location 0 is the accumulation target,
+// location 1 the revealage target.
+
+layout(location = 0) out vec4 accum;
+layout(location = 1) out float revealage;
+
+// Weight of a fragment in the average: grows with alpha and falls off with
+// depth, so a near fragment dominates a far one of the same alpha. This is
+// the depth weight of McGuire and Bavoil, clamped to what RGBA16F holds.
+float transparencyWeight(float alpha) {
+    float z = gl_FragCoord.z;
+    return clamp(alpha * max(1e-2, 3e3 * pow(1.0 - z, 3.0)), 1e-2, 3e3);
+}
+
+// color is not premultiplied
+void writeTransparent(vec4 color) {
+    float weight = transparencyWeight(color.a);
+    accum = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = color.a; // the blend keeps the product of (1 - alpha)
+}
@@ -0,0 +1,14 @@
+// View frustum test, the planes come from Frustum.h
+
+uniform vec4 frustumPlanes[6];
+
+// an AABB is outside if its most positive corner is behind any plane
+bool insideFrustum(vec3 bmin, vec3 bmax) {
+    for (int i = 0; i < 6; i++) {
+        vec4 plane = frustumPlanes[i];
+        vec3 p = mix(bmin, bmax, greaterThanEqual(plane.xyz, vec3(0.0)));
+        if (dot(plane.xyz, p) + plane.w < 0.0)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+// Water clipmap layout, shared by the water kernels and grid.vs.glsl through #include.
+// Level l is a gridRes x gridRes vertex grid with spacing gridSpacing * 2^l centred
+// on gridCenter, its vertices are stored from l * gridRes * gridRes on.
+// World xz is a function of the vertex index, so only the height and the
+// normal are stored - 8 bytes per vertex.
+
+struct WaterVertex {
+    float height;
+    uint normal; // octahedral, packSnorm2x16 - see encodeNormal
+};
+
+uniform uint gridRes;
+uniform float gridSpacing;
+uniform vec2 gridCenter;
+
+float levelSpacing(uint level) {
+    return gridSpacing * exp2(float(level));
+}
+
+vec2 gridToWorld(ivec2 cell, uint level) {
+    return gridCenter + (vec2(cell) - float(gridRes - 1u) * 0.5) * levelSpacing(level);
+}
+
+uint vertexIndex(uvec2 cell, uint level) {
+    return (level * gridRes + cell.y) * gridRes + cell.x;
+}
+
+// inverse of vertexIndex, used by the vertex shader to rebuild world xz
+ivec2 vertexCell(uint index, out uint level) {
+    uint levelSize = gridRes * gridRes;
+    level = index / levelSize;
+    index -= level * levelSize;
+    return ivec2(index % gridRes, index / gridRes);
+}
+
+// octahedral normal encoding, folded around the y (up) axis
+vec2 octWrap(vec2 v) {
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+uint encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.y >= 0.0 ? n.xz : octWrap(n.xz);
+    return packSnorm2x16(e);
+}
+
+vec3 decodeNormal(uint encoded) {
+    vec2 e = unpackSnorm2x16(encoded);
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    float t = max(-n.y, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.z += n.z >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// Index-free topology for glDrawArrays: 6 vertices per cell, same winding as
+// the index buffer built by WaterClipmap. A ring leaves out the middle half of
+// the level, its cells are enumerated as top band, bottom band, then the left
+// and right parts of the middle rows.
+uint indexFreeVertex(uint id, uint level, bool ring) {
+    const uvec2 corners[6] = uvec2[6](uvec2(0, 0), uvec2(0, 1), uvec2(1, 0), uvec2(1, 0), uvec2(0, 1), uvec2(1, 1));
+
+    uint cells = gridRes - 1u;
+    uint cellIndex = id / 6u;
+    uvec2 cell = uvec2(cellIndex % cells, cellIndex / cells);
+
+    if (ring) {
+        uint q = cells / 4u;
+        uint band = q * cells;
+        if (cellIndex >= 2u * band) {
+            uint j = cellIndex - 2u * band;
+            uint column = j % (2u * q);
+            cell = uvec2(column < q ? column : column + 2u * q, q + j / (2u * q));
+        }
+        else if (cellIndex >= band) {
+            uint j = cellIndex - band;
+            cell = uvec2(j % cells, 3u * q + j / cells);
+        }
+    }
+
+    return vertexIndex(cell + corners[id % 6u], level);
+}
+
+// Odd vertices on the outer border of a level lie in the middle of an edge of the
+// next, coarser level. Their height has to be the average of the two neighbours
+// along the border, otherwise they leave a T-junction crack.
+bool stitchNeighbours(ivec2 cell, out ivec2 a, out ivec2 b) {
+    int last = int(gridRes) - 1;
+    if ((cell.x == 0 || cell.x == last) && (cell.y & 1) == 1) {
+        a = cell - ivec2(0, 1);
+        b = cell + ivec2(0, 1);
+        return true;
+    }
+    if ((cell.y == 0 || cell.y == last) && (cell.x & 1) == 1) {
+        a = cell - ivec2(1, 0);
+        b = cell + ivec2(1, 0);
+        return true;
+    }
+    a = cell;
+    b = cell;
+    return false;
+}
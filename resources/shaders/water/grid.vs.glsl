@@ -1,11 +1,14 @@
 #version 430 core
 
-layout(std430, binding = 0) buffer vertPosBuffer {
-    vec4 positions[];
+#include "grid.glsl"
+
+layout(std430, binding = 0) readonly buffer vertBuffer {
+    WaterVertex vertices[];
 };
 
-layout(std430, binding = 1) buffer normalsBuffer  {
-    vec4 normals[];
+// the step before, see WaterClipmap::update
+layout(std430, binding = 1) readonly buffer previousVertBuffer {
+    WaterVertex previousVertices[];
 };
 
 out vec3 vNormal;
@@ -15,9 +18,36 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// index-free draws - the vertex index is derived from gl_VertexID, one instance per level
+uniform bool indexFree;
+uniform uint firstLevel;
+uniform bool ring;
+
+// fixed-step simulation - 0 shows the previous step, 1 the latest one
+uniform vec2 previousGridCenter;
+uniform float interpolation;
+
 void main() {
-    vec3 pos = positions[gl_VertexID].xyz;
-    vec3 normal = normals[gl_VertexID].xyz;
+    uint index = indexFree ? indexFreeVertex(uint(gl_VertexID), firstLevel + uint(gl_InstanceID), ring) : uint(gl_VertexID);
+
+    // vertex pulling - world xz comes from the vertex index, only height and normal are stored
+    uint level;
+    ivec2 cell = vertexCell(index, level);
+    vec2 xz = gridToWorld(cell, level);
+
+    WaterVertex vertex = vertices[index];
+    float height = vertex.height;
+    vec3 normal = decodeNormal(vertex.normal);
+
+    // Both centres are snapped to the coarsest spacing, so the previous step's
+    // vertex at the same world position is a whole number of cells away on every level.
+    ivec2 previousCell = cell + ivec2(round((gridCenter - previousGridCenter) / levelSpacing(level)));
+    if (all(greaterThanEqual(previousCell, ivec2(0))) && all(lessThan(previousCell, ivec2(gridRes)))) {
+        WaterVertex previous = previousVertices[vertexIndex(uvec2(previousCell), level)];
+        height = mix(previous.height, height, interpolation);
+        normal = normalize(mix(decodeNormal(previous.normal), normal, interpolation));
+    }
+    vec3 pos = vec3(xz.x, height, xz.y);
 
     gl_Position = projection * view * model * vec4(pos, 1.0);
     vNormal = mat3(transpose(inverse(model))) * normal;
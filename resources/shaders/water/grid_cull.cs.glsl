@@ -0,0 +1,60 @@
+#version 430 core
+
+// Water tile culling: one invocation per 16x16-cell tile of every clipmap level.
+// Writes one indirect draw command per tile slot - instanceCount 0 for tiles
+// outside the view frustum and for tiles in the hole of a ring.
+
+layout (local_size_x = 64) in;
+
+#include "grid.glsl"
+#include "frustum.glsl"
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 4) writeonly buffer drawCommandBuffer {
+    DrawCommand commands[];
+};
+
+layout(binding = 0, offset = 0) uniform atomic_uint visibleTiles;
+layout(binding = 0, offset = 4) uniform atomic_uint culledTiles;
+
+uniform uint levels;
+uniform uint tileCells;
+uniform uint tileIndexCount;
+uniform float maxWaveHeight;
+
+void main() {
+    uint tilesPerSide = (gridRes - 1u) / tileCells;
+    uint tilesPerLevel = tilesPerSide * tilesPerSide;
+    uint slot = gl_GlobalInvocationID.x;
+    if (slot >= levels * tilesPerLevel) return;
+
+    uint level = slot / tilesPerLevel;
+    uint t = slot % tilesPerLevel;
+    uvec2 tile = uvec2(t % tilesPerSide, t / tilesPerSide);
+    uvec2 cell = tile * tileCells;
+
+    // the middle half of a ring is covered by the finer level
+    uint holeStart = tilesPerSide / 4u;
+    uint holeEnd = tilesPerSide - holeStart;
+    bool hole = level > 0u && all(greaterThanEqual(tile, uvec2(holeStart))) && all(lessThan(tile, uvec2(holeEnd)));
+
+    vec2 minXZ = gridToWorld(ivec2(cell), level);
+    vec2 maxXZ = gridToWorld(ivec2(cell + tileCells), level);
+    bool visible = !hole && insideFrustum(vec3(minXZ.x, -maxWaveHeight, minXZ.y), vec3(maxXZ.x, maxWaveHeight, maxXZ.y));
+
+    commands[slot] = DrawCommand(tileIndexCount, visible ? 1u : 0u, 0u, int(vertexIndex(cell, level)), 0u);
+
+    if (!hole) {
+        if (visible)
+            atomicCounterIncrement(visibleTiles);
+        else
+            atomicCounterIncrement(culledTiles);
+    }
+}
@@ -0,0 +1,58 @@
+#version 430 core
+
+// Fused water pass: heights for a 16x16 tile plus a one-cell halo go to shared
+// memory, normals are then taken from the tile instead of re-reading global memory.
+// Replaces grid_height.cs.glsl + grid_normals.cs.glsl with one dispatch.
+
+#define TILE 16
+#define HALO_TILE (TILE + 2)
+
+layout (local_size_x = TILE, local_size_y = TILE) in;
+
+#include "wave.glsl"
+#include "grid.glsl"
+
+layout(std430, binding = 0) writeonly buffer vertBuffer {
+    WaterVertex vertices[];
+};
+
+shared float heights[HALO_TILE][HALO_TILE];
+
+void main() {
+    // one clipmap level per z slice of the dispatch
+    uint level = gl_WorkGroupID.z;
+    ivec2 tileOrigin = ivec2(gl_WorkGroupID.xy) * TILE - 1;
+    uint local = gl_LocalInvocationIndex;
+
+    // 18x18 halo tile, 256 threads - some threads evaluate two heights.
+    // The halo is evaluated past the level border too, so edge normals need no clamping.
+    for (uint i = local; i < HALO_TILE * HALO_TILE; i += TILE * TILE) {
+        ivec2 t = ivec2(i % HALO_TILE, i / HALO_TILE);
+        heights[t.y][t.x] = waveHeight(gridToWorld(tileOrigin + t, level));
+    }
+
+    memoryBarrierShared();
+    barrier();
+
+    uint x = gl_GlobalInvocationID.x;
+    uint z = gl_GlobalInvocationID.y;
+    if (x >= gridRes || z >= gridRes) return;
+
+    ivec2 t = ivec2(gl_LocalInvocationID.xy) + 1;
+    float spacing = levelSpacing(level);
+
+    vec3 dx = vec3(2.0 * spacing, heights[t.y][t.x + 1] - heights[t.y][t.x - 1], 0.0);
+    vec3 dz = vec3(0.0, heights[t.y + 1][t.x] - heights[t.y - 1][t.x], 2.0 * spacing);
+    vec3 normal = normalize(cross(dz, dx));
+
+    // border neighbours are always inside the halo tile
+    ivec2 cell = ivec2(x, z);
+    ivec2 a, b;
+    float height = heights[t.y][t.x];
+    if (stitchNeighbours(cell, a, b))
+        height = 0.5 * (heights[t.y + a.y - cell.y][t.x + a.x - cell.x] + heights[t.y + b.y - cell.y][t.x + b.x - cell.x]);
+
+    uint index = vertexIndex(uvec2(x, z), level);
+    vertices[index].height = height;
+    vertices[index].normal = encodeNormal(normal);
+}
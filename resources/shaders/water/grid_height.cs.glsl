@@ -2,29 +2,37 @@
 
 layout (local_size_x = 16, local_size_y = 16) in;
 
-layout(std430, binding = 0) buffer vertPosBuffer {
-	vec4 positions[];
+#include "wave.glsl"
+#include "grid.glsl"
+
+layout(std430, binding = 0) buffer vertBuffer {
+	WaterVertex vertices[];
 };
 
-uniform float time;
-uniform uint gridRes;
+uniform bool analyticNormals; // closed-form normals, grid_normals.cs.glsl is not needed
 
-void main() {
-	float freq = 0.5;
-    float amp = 0.5;
+vec3 evaluate(ivec2 cell, uint level) {
+    vec2 p = gridToWorld(cell, level);
+    return analyticNormals ? waveHeightAndGradient(p) : vec3(waveHeight(p), 0.0, 0.0);
+}
 
-    // Calculate global index for 2D grid (you need to match this on CPU side too)
+void main() {
+    // one clipmap level per z slice of the dispatch
     uint x = gl_GlobalInvocationID.x;
     uint y = gl_GlobalInvocationID.y;
-    uint index = y * gridRes + x;
-
-    // Read current position
-    vec3 pos = positions[index].xyz;
-    float px = pos.x;
-    float pz = pos.z;
-
-    float height = sin(px * freq + time) * cos(pz * freq + time);
-    pos = vec3(px, height * amp, pz);
-
-    positions[index] = vec4(pos, 0.0);
-}
\ No newline at end of file
+    uint level = gl_GlobalInvocationID.z;
+    if (x >= gridRes || y >= gridRes) return;
+
+    ivec2 cell = ivec2(x, y);
+    ivec2 a, b;
+    vec3 wave;
+    if (stitchNeighbours(cell, a, b))
+        wave = 0.5 * (evaluate(a, level) + evaluate(b, level));
+    else
+        wave = evaluate(cell, level);
+
+    uint index = vertexIndex(uvec2(x, y), level);
+    vertices[index].height = wave.x;
+    if (analyticNormals)
+        vertices[index].normal = encodeNormal(vec3(-wave.y, 1.0, -wave.z));
+}
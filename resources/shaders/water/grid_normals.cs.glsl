@@ -1,40 +1,37 @@
 #version 430 core
 layout(local_size_x = 16, local_size_y = 16) in;
 
-layout(std430, binding = 0) readonly buffer VertexBuffer {
-    vec4 positions[];
-};
+#include "grid.glsl"
 
-layout(std430, binding = 1) writeonly buffer NormalBuffer {
-	vec4 normals[];
+// heights are read, normals written - different members of the same vertices
+layout(std430, binding = 0) buffer vertBuffer {
+    WaterVertex vertices[];
 };
 
-uniform uint gridRes; 
-
 void main() {
-    uvec2 id = gl_GlobalInvocationID.xy;
+    uvec3 id = gl_GlobalInvocationID;
     int x = int(id.x);
     int z = int(id.y);
+    uint level = id.z; // one clipmap level per z slice of the dispatch
 
     if (x >= gridRes || z >= gridRes) return;
 
-    int idx = z * int(gridRes) + x;
-
     // Clamp edges
     int x0 = max(int(x) - 1, 0);
     int x1 = min(int(x) + 1, int(gridRes) - 1);
     int z0 = max(int(z) - 1, 0);
     int z1 = min(int(z) + 1, int(gridRes) - 1);
 
-    vec3 pL = positions[z * gridRes + x0].xyz;
-    vec3 pR = positions[z * gridRes + x1].xyz;
-    vec3 pD = positions[z0 * gridRes + x].xyz;
-    vec3 pU = positions[z1 * gridRes + x].xyz;
+    float hL = vertices[vertexIndex(uvec2(x0, z), level)].height;
+    float hR = vertices[vertexIndex(uvec2(x1, z), level)].height;
+    float hD = vertices[vertexIndex(uvec2(x, z0), level)].height;
+    float hU = vertices[vertexIndex(uvec2(x, z1), level)].height;
 
-    vec3 dx = pR - pL;
-    vec3 dz = pU - pD;
+    float spacing = levelSpacing(level);
+    vec3 dx = vec3(float(x1 - x0) * spacing, hR - hL, 0.0);
+    vec3 dz = vec3(0.0, hU - hD, float(z1 - z0) * spacing);
 
     vec3 normal = normalize(cross(dz, dx));
 
-    normals[idx] = vec4(normal, 0.0);
+    vertices[vertexIndex(uvec2(x, z), level)].normal = encodeNormal(normal);
 }
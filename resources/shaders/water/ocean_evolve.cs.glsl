@@ -0,0 +1,41 @@
+#version 430 core
+
+// Tessendorf ocean - spectrum at time t:
+// h(k, t) = h0(k) e^(iwt) + conj(h0(-k)) e^(-iwt)
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout(std430, binding = 2) readonly buffer spectrumBuffer {
+    vec4 h0[];
+};
+
+layout(std430, binding = 3) writeonly buffer heightBuffer {
+    vec2 hkt[];
+};
+
+uniform uint fftSize;
+uniform float patchSize;
+uniform float time;
+
+const float PI = 3.14159265359;
+const float G = 9.81;
+
+vec2 cmul(vec2 a, vec2 b) {
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+void main() {
+    uint n = gl_GlobalInvocationID.x;
+    uint m = gl_GlobalInvocationID.y;
+    if (n >= fftSize || m >= fftSize) return;
+
+    uint index = m * fftSize + n;
+    vec2 k = (vec2(n, m) - float(fftSize) / 2.0) * (2.0 * PI / patchSize);
+    float omega = sqrt(G * length(k));
+
+    vec2 e = vec2(cos(omega * time), sin(omega * time));
+    vec2 eConj = vec2(e.x, -e.y);
+
+    vec4 spectrum = h0[index];
+    hkt[index] = cmul(spectrum.xy, e) + cmul(spectrum.zw, eConj);
+}
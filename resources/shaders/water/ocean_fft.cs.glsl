@@ -0,0 +1,57 @@
+#version 430 core
+
+// Tessendorf ocean - one pass of the 2D inverse FFT.
+// One work group transforms a whole row (direction 0) or column (direction 1)
+// in shared memory: bit-reversed load, then log2(N) radix-2 butterfly stages.
+
+#define FFT_SIZE 256
+#define LOG2_FFT_SIZE 8
+
+layout (local_size_x = FFT_SIZE / 2) in;
+
+layout(std430, binding = 3) buffer heightBuffer {
+    vec2 data[];
+};
+
+uniform uint direction;
+
+const float PI = 3.14159265359;
+
+shared vec2 line[FFT_SIZE];
+
+vec2 cmul(vec2 a, vec2 b) {
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+uint elementIndex(uint lineIndex, uint i) {
+    return direction == 0u ? lineIndex * FFT_SIZE + i : i * FFT_SIZE + lineIndex;
+}
+
+void main() {
+    uint lineIndex = gl_WorkGroupID.x;
+    uint t = gl_LocalInvocationID.x;
+
+    for (uint j = t; j < FFT_SIZE; j += FFT_SIZE / 2)
+        line[bitfieldReverse(j) >> (32 - LOG2_FFT_SIZE)] = data[elementIndex(lineIndex, j)];
+
+    memoryBarrierShared();
+    barrier();
+
+    for (uint span = 1u; span < FFT_SIZE; span <<= 1) {
+        uint pos = t & (span - 1u);
+        uint a = ((t - pos) << 1) + pos;
+        uint b = a + span;
+
+        float angle = PI * float(pos) / float(span);
+        vec2 u = line[a];
+        vec2 v = cmul(line[b], vec2(cos(angle), sin(angle)));
+        line[a] = u + v;
+        line[b] = u - v;
+
+        memoryBarrierShared();
+        barrier();
+    }
+
+    for (uint j = t; j < FFT_SIZE; j += FFT_SIZE / 2)
+        data[elementIndex(lineIndex, j)] = line[j];
+}
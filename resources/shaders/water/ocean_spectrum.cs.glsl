@@ -0,0 +1,64 @@
+#version 430 core
+
+// Tessendorf ocean - initial spectrum h0(k), run once at startup
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout(std430, binding = 2) writeonly buffer spectrumBuffer {
+    vec4 h0[]; // xy - h0(k), zw - conj(h0(-k))
+};
+
+uniform uint fftSize;
+uniform float patchSize;
+uniform float windSpeed;
+uniform vec2 windDir;
+uniform float amplitude;
+uniform uint seed;
+
+const float PI = 3.14159265359;
+const float G = 9.81;
+
+#include "../random.glsl"
+
+// two independent N(0, 1) samples (Box-Muller), must match OceanSpectrum::gaussianPair
+vec2 gaussianPair(uint index) {
+    uint s = pcgHash(seed);
+    float u1 = (float(pcgHash(2u * index + s) >> 8) + 1.0) / 16777216.0;
+    float u2 = float(pcgHash(2u * index + 1u + s) >> 8) / 16777216.0;
+    float r = sqrt(-2.0 * log(u1));
+    float theta = 2.0 * PI * u2;
+    return vec2(r * cos(theta), r * sin(theta));
+}
+
+float phillips(vec2 k) {
+    float k2 = dot(k, k);
+    if (k2 < 1e-8)
+        return 0.0;
+
+    float L = windSpeed * windSpeed / G;
+    float kdw = dot(k / sqrt(k2), windDir);
+    float p = amplitude * exp(-1.0 / (k2 * L * L)) / (k2 * k2) * kdw * kdw;
+    if (kdw < 0.0)
+        p *= 0.07;
+
+    float l = L * 0.001;
+    return p * exp(-k2 * l * l);
+}
+
+void main() {
+    uint n = gl_GlobalInvocationID.x;
+    uint m = gl_GlobalInvocationID.y;
+    if (n >= fftSize || m >= fftSize) return;
+
+    vec2 k = (vec2(n, m) - float(fftSize) / 2.0) * (2.0 * PI / patchSize);
+    uint nMinus = (fftSize - n) % fftSize;
+    uint mMinus = (fftSize - m) % fftSize;
+
+    vec2 xi = gaussianPair(m * fftSize + n);
+    vec2 xiMinus = gaussianPair(mMinus * fftSize + nMinus);
+
+    float p = sqrt(phillips(k) * 0.5);
+    float pMinus = sqrt(phillips(-k) * 0.5);
+
+    h0[m * fftSize + n] = vec4(xi * p, xiMinus.x * pMinus, -xiMinus.y * pMinus);
+}
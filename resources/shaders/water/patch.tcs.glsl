@@ -0,0 +1,53 @@
+#version 430 core
+
+// Tessellation levels from the screen-space size of every patch edge. Each
+// level depends only on the two corners of its edge, so neighbouring patches
+// agree on the shared edge and no cracks appear.
+
+layout(vertices = 4) out;
+
+#include "frustum.glsl"
+
+in vec2 vWorldXZ[];
+out vec2 tcWorldXZ[];
+
+uniform vec3 viewPos;
+uniform float lodScale;
+uniform float maxWaveHeight;
+
+const float MAX_TESS_LEVEL = 64.0;
+
+// the edge is treated as a sphere around its midpoint, which stays stable when
+// the edge crosses the camera plane
+float edgeLevel(vec2 a, vec2 b) {
+    vec3 midpoint = vec3((a + b) * 0.5, 0.0).xzy;
+    float dist = max(distance(midpoint, viewPos), 0.001);
+    return clamp(distance(a, b) / dist * lodScale, 1.0, MAX_TESS_LEVEL);
+}
+
+void main() {
+    tcWorldXZ[gl_InvocationID] = vWorldXZ[gl_InvocationID];
+
+    if (gl_InvocationID == 0) {
+        vec2 bmin = min(min(vWorldXZ[0], vWorldXZ[1]), min(vWorldXZ[2], vWorldXZ[3]));
+        vec2 bmax = max(max(vWorldXZ[0], vWorldXZ[1]), max(vWorldXZ[2], vWorldXZ[3]));
+        if (!insideFrustum(vec3(bmin.x, -maxWaveHeight, bmin.y), vec3(bmax.x, maxWaveHeight, bmax.y))) {
+            // a zero outer level discards the patch
+            gl_TessLevelOuter[0] = 0.0;
+            gl_TessLevelOuter[1] = 0.0;
+            gl_TessLevelOuter[2] = 0.0;
+            gl_TessLevelOuter[3] = 0.0;
+            gl_TessLevelInner[0] = 0.0;
+            gl_TessLevelInner[1] = 0.0;
+            return;
+        }
+
+        // outer 0: u = 0, 1: v = 0, 2: u = 1, 3: v = 1
+        gl_TessLevelOuter[0] = edgeLevel(vWorldXZ[0], vWorldXZ[3]);
+        gl_TessLevelOuter[1] = edgeLevel(vWorldXZ[0], vWorldXZ[1]);
+        gl_TessLevelOuter[2] = edgeLevel(vWorldXZ[1], vWorldXZ[2]);
+        gl_TessLevelOuter[3] = edgeLevel(vWorldXZ[3], vWorldXZ[2]);
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
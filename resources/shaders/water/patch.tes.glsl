@@ -0,0 +1,31 @@
+#version 430 core
+
+// Displaces the tessellated patch with the shared wave model and hands the
+// same outputs as grid.vs.glsl to grid.fs.glsl.
+
+// u runs along +x and v along +z, so cw in the domain is ccw seen from above
+layout(quads, fractional_even_spacing, cw) in;
+
+#include "wave.glsl"
+
+in vec2 tcWorldXZ[];
+
+out vec3 vNormal;
+out vec3 fragPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    vec2 xz = mix(mix(tcWorldXZ[0], tcWorldXZ[1], gl_TessCoord.x),
+                  mix(tcWorldXZ[3], tcWorldXZ[2], gl_TessCoord.x), gl_TessCoord.y);
+
+    vec3 heightAndGradient = waveHeightAndGradient(xz);
+    vec3 pos = vec3(xz.x, heightAndGradient.x, xz.y);
+    vec3 normal = normalize(vec3(-heightAndGradient.y, 1.0, -heightAndGradient.z));
+
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+    vNormal = mat3(transpose(inverse(model))) * normal;
+    fragPos = vec3(model * vec4(pos, 1.0));
+}
@@ -0,0 +1,19 @@
+#version 430 core
+
+// Tessellated water, see WaterPatchGrid. Four vertices per patch, the corner
+// is derived from gl_VertexID: (0, 0), (1, 0), (1, 1), (0, 1).
+
+uniform uint patchesPerSide;
+uniform float patchWidth;
+uniform vec2 patchGridCenter;
+
+out vec2 vWorldXZ;
+
+void main() {
+    uint patchIndex = uint(gl_VertexID) / 4u;
+    uint corner = uint(gl_VertexID) % 4u;
+    uvec2 cell = uvec2(patchIndex % patchesPerSide, patchIndex / patchesPerSide)
+               + uvec2(corner == 1u || corner == 2u ? 1u : 0u, corner >= 2u ? 1u : 0u);
+
+    vWorldXZ = patchGridCenter + (vec2(cell) - vec2(patchesPerSide) * 0.5) * patchWidth;
+}
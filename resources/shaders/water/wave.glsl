@@ -0,0 +1,71 @@
+// Water wave model, shared by the water kernels through #include.
+// waveModel 0 - single sin*cos wave, 1 - FFT ocean (OceanFFT height field at binding 3)
+
+layout(std430, binding = 3) readonly buffer oceanHeightBuffer {
+    vec2 hkt[];
+};
+
+uniform uint waveModel;
+uniform float time;
+uniform uint fftSize;
+uniform float patchSize;
+
+const float SINE_FREQ = 0.5;
+const float SINE_AMP = 0.5;
+
+float sineWaveHeight(vec2 p) {
+    return sin(p.x * SINE_FREQ + time) * cos(p.y * SINE_FREQ + time) * SINE_AMP;
+}
+
+// x - height, yz - closed-form dh/dx, dh/dz
+vec3 sineWaveHeightAndGradient(vec2 p) {
+    float sx = sin(p.x * SINE_FREQ + time);
+    float cx = cos(p.x * SINE_FREQ + time);
+    float sz = sin(p.y * SINE_FREQ + time);
+    float cz = cos(p.y * SINE_FREQ + time);
+    return vec3(sx * cz, cx * cz * SINE_FREQ, -sx * sz * SINE_FREQ) * SINE_AMP;
+}
+
+// the spectrum is centred on k = 0, which flips the sign of every other texel
+float fftTexel(ivec2 c) {
+    c &= ivec2(int(fftSize) - 1);
+    float s = ((c.x + c.y) & 1) == 0 ? 1.0 : -1.0;
+    return hkt[uint(c.y) * fftSize + uint(c.x)].x * s;
+}
+
+// bilinear lookup, the ocean patch is periodic so it tiles over the whole grid
+float fftWaveHeight(vec2 p) {
+    vec2 uv = p / patchSize * float(fftSize);
+    ivec2 c = ivec2(floor(uv));
+    vec2 f = uv - vec2(c);
+
+    float h00 = fftTexel(c);
+    float h10 = fftTexel(c + ivec2(1, 0));
+    float h01 = fftTexel(c + ivec2(0, 1));
+    float h11 = fftTexel(c + ivec2(1, 1));
+    return mix(mix(h00, h10, f.x), mix(h01, h11, f.x), f.y);
+}
+
+// x - height, yz - exact gradient of the bilinear interpolant
+vec3 fftWaveHeightAndGradient(vec2 p) {
+    vec2 uv = p / patchSize * float(fftSize);
+    ivec2 c = ivec2(floor(uv));
+    vec2 f = uv - vec2(c);
+
+    float h00 = fftTexel(c);
+    float h10 = fftTexel(c + ivec2(1, 0));
+    float h01 = fftTexel(c + ivec2(0, 1));
+    float h11 = fftTexel(c + ivec2(1, 1));
+
+    float height = mix(mix(h00, h10, f.x), mix(h01, h11, f.x), f.y);
+    vec2 gradient = vec2(mix(h10 - h00, h11 - h01, f.y), mix(h01 - h00, h11 - h10, f.x));
+    return vec3(height, gradient * (float(fftSize) / patchSize));
+}
+
+float waveHeight(vec2 p) {
+    return waveModel == 1u ? fftWaveHeight(p) : sineWaveHeight(p);
+}
+
+vec3 waveHeightAndGradient(vec2 p) {
+    return waveModel == 1u ? fftWaveHeightAndGradient(p) : sineWaveHeightAndGradient(p);
+}
@@ -0,0 +1,34 @@
+// Camera-facing particle quads built in the vertex shader, shared by the wind
+// particle vertex shaders through #include. There is no vertex buffer: each
+// particle is six vertices (two triangles) and gl_VertexID picks the corner.
+
+const vec2 BILLBOARD_CORNERS[6] = vec2[](
+    vec2(-0.5, 0.5), vec2(0.5, -0.5), vec2(-0.5, -0.5),
+    vec2(-0.5, 0.5), vec2(0.5, 0.5), vec2(0.5, -0.5)
+);
+
+uniform bool velocityStreaks; // stretch the quads along the screen-space velocity
+uniform float streakLength;   // seconds of motion a streak covers
+
+// world position of this vertex's corner of the quad around center
+vec3 billboardVertex(vec3 center, float scale, vec3 velocity, mat4 view) {
+    vec2 corner = BILLBOARD_CORNERS[gl_VertexID % 6];
+
+    // the rows of the view rotation are the camera axes in world space
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 back = vec3(view[0][2], view[1][2], view[2][2]);
+
+    if (velocityStreaks) {
+        vec3 across = velocity - dot(velocity, back) * back;
+        float speed = length(across);
+        if (speed > 1e-4) {
+            // long axis along the motion, the streak trails behind the particle
+            vec3 axis = across / speed;
+            float extent = scale + speed * streakLength;
+            vec3 side = normalize(cross(axis, back));
+            return center + side * (corner.x * scale) + axis * ((corner.y - 0.5) * extent + 0.5 * scale);
+        }
+    }
+    return center + (right * corner.x + up * corner.y) * scale;
+}
@@ -1,9 +1,10 @@
 #version 330 core
+
+#include "../transparency/oit.glsl"
+
 in vec4 ParticleColor;
 in vec3 FragPos;
 
-out vec4 color;
-
 struct DirLight {
     vec3 direction;
     vec3 ambient;
@@ -12,6 +13,7 @@ struct DirLight {
 };
 
 uniform DirLight sun;
+uniform bool weightedBlended; // drawn into TransparencyPass, otherwise blended straight into the window
 
 void main()
 {
@@ -20,5 +22,8 @@ void main()
     // Ambient
     vec3 ambient = sun.ambient * ParticleColor.rgb * aboveHorizon * 5.0;
 
-    color = vec4(ambient, ParticleColor.w);
-}  
\ No newline at end of file
+    if (weightedBlended)
+        writeTransparent(vec4(ambient, ParticleColor.w));
+    else
+        accum = vec4(ambient, ParticleColor.w);
+}
@@ -0,0 +1,10 @@
+// Wind particle layout, shared by the particle kernels and v_wind_particle_gpu.glsl
+// through #include. Must match GpuParticle in GpuParticleSystem.h.
+//
+// SSBO bindings: 5 - particles, 6 - dead list, 7 - alive list
+
+struct WindParticle {
+    vec4 position; // xyz, w - remaining life, <= 0 when dead
+    vec4 color;    // rgb, a - alpha
+    vec4 params;   // x - seed, the phase of the side sway, yzw - velocity
+};
@@ -0,0 +1,64 @@
+#version 430 core
+
+// Spawns emitCount wind particles into slots popped from the dead list, with
+// the same shape as ParticleEmitter::spawn. When the pool is full the
+// remaining spawns are dropped instead of overwriting live particles.
+//
+// Spawn number spawnOffset + id draws from random stream spawnOffset + id, the
+// same stream ParticleEmitter::spawn uses for that spawn, so both spawners produce
+// the same particles from the same seed.
+
+layout (local_size_x = 64) in;
+
+#include "particle.glsl"
+#include "../random.glsl"
+
+layout(std430, binding = 5) writeonly buffer particleBuffer {
+    WindParticle particles[];
+};
+
+layout(std430, binding = 6) buffer deadListBuffer {
+    uint deadCount;
+    uint deadIndices[];
+};
+
+uniform uint emitCount;
+uniform uint spawnSeed;
+uniform uint spawnOffset;
+uniform vec3 emitterPos;
+uniform vec3 windDirection;
+uniform float particleLife;
+
+const float PI = 3.14159265359;
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= emitCount) return;
+
+    // only pops happen in this pass, so a failed pop can simply be undone
+    uint available = atomicAdd(deadCount, 0xFFFFFFFFu);
+    if (int(available) <= 0) {
+        atomicAdd(deadCount, 1u);
+        return;
+    }
+    uint index = deadIndices[available - 1u];
+
+    const float maxDistanceAgainstWind = 22.0;
+    const float minDistanceFromCamera = 8.0;
+    const float tunnelWidth = 14.0;
+
+    RandomStream random = randomStream(spawnSeed, spawnOffset + id);
+    float rColor = randomRange(random, 0.8, 0.9);
+    float particleHeight = randomRange(random, 0.2, 4.2);
+    float distanceAgainstWind = randomRange(random, minDistanceFromCamera, maxDistanceAgainstWind);
+    float distanceToSide = randomRange(random, -tunnelWidth / 2.0, tunnelWidth / 2.0);
+
+    vec3 wind = normalize(windDirection);
+    vec3 side = normalize(cross(wind, vec3(0.0, 1.0, 0.0)));
+    vec3 offset = -wind * distanceAgainstWind + side * distanceToSide; // same offset as ParticleEmitter::spawn
+    offset.y = particleHeight;
+
+    particles[index].position = vec4(emitterPos + offset, particleLife);
+    particles[index].color = vec4(vec3(rColor), 0.0);
+    particles[index].params = vec4(randomRange(random, -PI, PI), 0.0, 0.0, 0.0);
+}
@@ -0,0 +1,23 @@
+// Bitonic sort of the alive list by view depth, shared by the sort kernels
+// through #include. Keys are uvec2(depth key, particle index) and sort in
+// descending order, far particles first, so blending composites back to front.
+//
+// SSBO binding 8 - sort keys, sortCount of them (a power of two)
+// SSBO binding 10 - sortCount, then the indirect dispatches of the sort (particle_sort_args.cs.glsl)
+
+const uint SORT_BLOCK = 1024u; // keys sorted in shared memory by one work group of 512
+
+layout(std430, binding = 8) buffer sortKeyBuffer {
+    uvec2 sortKeys[];
+};
+
+layout(std430, binding = 10) buffer sortDispatchBuffer {
+    uint sortCount;      // the next power of two at or above the live count, at least SORT_BLOCK
+    uint dispatchArgs[]; // DispatchIndirectCommand { x, y, z } of every sort pass in order
+};
+
+// true when the pair (i, i + j) of merge stage k has to be swapped
+bool outOfOrder(uvec2 a, uvec2 b, uint i, uint k) {
+    bool descending = (i & k) == 0u;
+    return descending ? a.x < b.x : a.x > b.x;
+}
@@ -0,0 +1,43 @@
+#version 430 core
+
+// Sizes the bitonic sort to the live particles rather than the capacity.
+// sortCount becomes the next power of two at or above aliveCount, and every
+// pass of the full schedule GpuParticleSystem::sort() issues gets its work
+// group count: 0 for the merge stages above sortCount, which then do nothing.
+
+layout (local_size_x = 1) in;
+
+#include "particle_sort.glsl"
+
+layout(std430, binding = 7) readonly buffer aliveListBuffer {
+    uint vertexCount;
+    uint aliveCount; // instanceCount
+    uint firstVertex;
+    uint baseInstance;
+    uint aliveIndices[];
+};
+
+uniform uint maxSortSize; // the schedule sort() runs, a power of two at or above the capacity
+
+void setDispatch(uint pass, uint groups) {
+    dispatchArgs[3u * pass] = groups;
+    dispatchArgs[3u * pass + 1u] = 1u;
+    dispatchArgs[3u * pass + 2u] = 1u;
+}
+
+void main() {
+    uint n = SORT_BLOCK;
+    while (n < aliveCount)
+        n <<= 1;
+    sortCount = n;
+
+    // same order as sort(): the local sort, then per merge stage its global steps and local merge
+    uint pass = 0u;
+    setDispatch(pass++, n / SORT_BLOCK);
+    for (uint k = 2u * SORT_BLOCK; k <= maxSortSize; k <<= 1) {
+        bool active = k <= n;
+        for (uint j = k >> 1; j >= SORT_BLOCK; j >>= 1)
+            setDispatch(pass++, active ? n / 2u / 512u : 0u);
+        setDispatch(pass++, active ? n / SORT_BLOCK : 0u);
+    }
+}
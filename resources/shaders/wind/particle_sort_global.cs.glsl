@@ -0,0 +1,24 @@
+#version 430 core
+
+// One compare-exchange step of a bitonic merge stage with a distance too
+// large for particle_sort_local.cs.glsl (j >= SORT_BLOCK). One invocation per pair.
+
+layout (local_size_x = 512) in;
+
+#include "particle_sort.glsl"
+
+uniform uint k; // merge stage, the size of the sequences being merged
+uniform uint j; // compare distance
+
+void main() {
+    uint t = gl_GlobalInvocationID.x;
+    if (t >= sortCount / 2u) return;
+
+    uint i = 2u * j * (t / j) + t % j;
+    uvec2 a = sortKeys[i];
+    uvec2 b = sortKeys[i + j];
+    if (outOfOrder(a, b, i, k)) {
+        sortKeys[i] = b;
+        sortKeys[i + j] = a;
+    }
+}
@@ -0,0 +1,88 @@
+#version 430 core
+
+// The part of the bitonic sort that stays within blocks of SORT_BLOCK keys,
+// done in shared memory. mergeStage 0 builds the keys from the alive list and
+// sorts every block; mergeStage k runs the steps of stage k with j < SORT_BLOCK.
+// The last pass, the one that completes sortCount keys, writes the sorted
+// indices back to the alive list, which the particle draw reads in order.
+
+layout (local_size_x = 512) in;
+
+#include "particle.glsl"
+#include "particle_sort.glsl"
+
+layout(std430, binding = 5) readonly buffer particleBuffer {
+    WindParticle particles[];
+};
+
+layout(std430, binding = 7) buffer aliveListBuffer {
+    uint vertexCount;
+    uint aliveCount; // instanceCount
+    uint firstVertex;
+    uint baseInstance;
+    uint aliveIndices[];
+};
+
+uniform uint mergeStage;
+uniform mat4 view;
+
+shared uvec2 block[SORT_BLOCK];
+
+// live particles get their view depth + 1 as key, so every key is above the
+// 0 of the empty slots after them; for positive floats the bits sort like the values
+uvec2 depthKey(uint slot) {
+    if (slot >= aliveCount)
+        return uvec2(0u);
+    uint index = aliveIndices[slot];
+    float depth = -(view * vec4(particles[index].position.xyz, 1.0)).z;
+    return uvec2(floatBitsToUint(max(depth, 0.0) + 1.0), index);
+}
+
+void compareExchange(uint t, uint base, uint k, uint j) {
+    uint i = 2u * j * (t / j) + t % j;
+    uvec2 a = block[i];
+    uvec2 b = block[i + j];
+    if (outOfOrder(a, b, base + i, k)) {
+        block[i] = b;
+        block[i + j] = a;
+    }
+}
+
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint base = gl_WorkGroupID.x * SORT_BLOCK;
+    uint halfBlock = SORT_BLOCK / 2u;
+
+    if (mergeStage == 0u) {
+        block[t] = depthKey(base + t);
+        block[t + halfBlock] = depthKey(base + t + halfBlock);
+    }
+    else {
+        block[t] = sortKeys[base + t];
+        block[t + halfBlock] = sortKeys[base + t + halfBlock];
+    }
+    barrier();
+
+    if (mergeStage == 0u) {
+        for (uint k = 2u; k <= SORT_BLOCK; k <<= 1) {
+            for (uint j = k >> 1; j > 0u; j >>= 1) {
+                compareExchange(t, base, k, j);
+                barrier();
+            }
+        }
+    }
+    else {
+        for (uint j = halfBlock; j > 0u; j >>= 1) {
+            compareExchange(t, base, mergeStage, j);
+            barrier();
+        }
+    }
+
+    bool writeIndices = (mergeStage == 0u ? SORT_BLOCK : mergeStage) == sortCount;
+    for (uint n = 0u; n < 2u; n++) {
+        uint i = t + n * halfBlock;
+        sortKeys[base + i] = block[i];
+        if (writeIndices && base + i < aliveCount)
+            aliveIndices[base + i] = block[i].y;
+    }
+}
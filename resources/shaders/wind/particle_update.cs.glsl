@@ -0,0 +1,66 @@
+#version 430 core
+
+// Ages, moves and fades every wind particle. Particles that die push their
+// index to the dead list, live ones append theirs to the alive list, whose
+// header is the indirect draw command of the particle draw.
+
+layout (local_size_x = 256) in;
+
+#include "particle.glsl"
+
+layout(std430, binding = 5) buffer particleBuffer {
+    WindParticle particles[];
+};
+
+layout(std430, binding = 6) buffer deadListBuffer {
+    uint deadCount;
+    uint deadIndices[];
+};
+
+layout(std430, binding = 7) buffer aliveListBuffer {
+    uint vertexCount;
+    uint aliveCount; // instanceCount
+    uint firstVertex;
+    uint baseInstance;
+    uint aliveIndices[];
+};
+
+uniform uint particleCount;
+uniform float deltaTime;
+uniform float time;
+uniform vec3 windDirection;
+uniform float windSpeed;
+uniform float windWaveFrequency;
+uniform float sideAmplitude;
+uniform float particleLife;
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= particleCount) return;
+
+    WindParticle p = particles[i];
+    if (p.position.w <= 0.0) return; // already in the dead list
+
+    p.position.w -= deltaTime;
+    if (p.position.w <= 0.0) {
+        p.color.a = 0.0;
+        particles[i] = p;
+        deadIndices[atomicAdd(deadCount, 1u)] = i;
+        return;
+    }
+
+    vec3 sideAxis = normalize(cross(windDirection, vec3(0.0, 1.0, 0.0)));
+    float sideOffset = sin((time + p.params.x) * windWaveFrequency) * sideAmplitude;
+    vec3 velocity = normalize(windDirection + sideAxis * sideOffset) * windSpeed;
+    p.position.xyz += velocity * deltaTime;
+    p.params.yzw = velocity; // for velocity streaks
+
+    float fade = deltaTime * 2.5;
+    if (p.position.w < 1.0)
+        p.color.a -= fade;
+    else if (p.position.w > particleLife - 1.0 && p.color.a < 1.0 - fade)
+        p.color.a += fade;
+
+    particles[i] = p;
+    aliveIndices[atomicAdd(aliveCount, 1u)] = i;
+}
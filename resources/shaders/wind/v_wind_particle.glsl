@@ -1,22 +1,30 @@
-#version 330 core
-layout (location = 0) in vec3 aPos;
+#version 430 core
+
+#include "billboard.glsl"
+
+// must match ParticleInstance in ParticleRenderer.h
+struct ParticleInstance {
+    vec4 positionScale; // xyz, w - scale
+    vec4 color;
+    vec4 velocity;      // xyz, w unused
+};
+
+layout(std430, binding = 9) readonly buffer instanceBuffer {
+    ParticleInstance instances[];
+};
 
 out vec4 ParticleColor;
 out vec3 FragPos;
 
-uniform vec4 color;
-
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// one instance per particle, see ParticleRenderer
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-
-    //float scale = 10.0f;
-    ParticleColor = color;
-    //gl_Position = projection * view * model * vec4(aPos * scale, 1.0f);
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    ParticleInstance particle = instances[gl_InstanceID];
 
-}
\ No newline at end of file
+    FragPos = billboardVertex(particle.positionScale.xyz, particle.positionScale.w, particle.velocity.xyz, view);
+    ParticleColor = particle.color;
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
+}
@@ -0,0 +1,34 @@
+#version 430 core
+
+#include "particle.glsl"
+#include "billboard.glsl"
+
+layout(std430, binding = 5) readonly buffer particleBuffer {
+    WindParticle particles[];
+};
+
+layout(std430, binding = 7) readonly buffer aliveListBuffer {
+    uint vertexCount;
+    uint aliveCount;
+    uint firstVertex;
+    uint baseInstance;
+    uint aliveIndices[];
+};
+
+out vec4 ParticleColor;
+out vec3 FragPos;
+
+uniform float particleScale;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// one instance per live particle, see GpuParticleSystem
+void main()
+{
+    WindParticle particle = particles[aliveIndices[gl_InstanceID]];
+
+    FragPos = billboardVertex(particle.position.xyz, particleScale, particle.params.yzw, view);
+    ParticleColor = particle.color;
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
+}
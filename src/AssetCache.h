@@ -0,0 +1,238 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+// Include this before Mesh.h: its using namespace std makes byte ambiguous in the Windows headers
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL) {
+            close();
+            return false;
+        }
+        bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        length = (size_t)fileSize.QuadPart;
+#else
+        descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return false;
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            close();
+            return false;
+        }
+        void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        bytes = view == MAP_FAILED ? nullptr : (const unsigned char*)view;
+        length = (size_t)status.st_size;
+#endif
+        if (bytes == nullptr) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (bytes != nullptr)
+            UnmapViewOfFile(bytes);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes != nullptr)
+            munmap((void*)bytes, length);
+        if (descriptor >= 0)
+            ::close(descriptor);
+        descriptor = -1;
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const unsigned char* data() const
+    {
+        return bytes;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int descriptor = -1;
+#endif
+};
+
+// Shared parts of the baked asset files (MeshCache, TextureCache).
+//
+// Baked files live under BAKE_DIRECTORY, at the path of their source relative
+// to resources/ plus an extension, e.g. resources/models/shark/shark.obj ->
+// resources/baked/models/shark/shark.obj.meshcache. asset_baker fills the
+// directory ahead of time; the app uses what it finds there and falls back to
+// the source otherwise. Every baked file records the size and a hash of the
+// contents of its source and is ignored once they no longer match.
+//
+// The key leaves out the modification time on purpose: the build copies
+// resources/ next to the executable and a git checkout rewrites the files,
+// both with new times, and the baked files have to stay valid through that.
+class AssetCache
+{
+public:
+    static constexpr const char* SOURCE_DIRECTORY = "resources/";
+    static constexpr const char* BAKE_DIRECTORY = "resources/baked/";
+
+    static std::string bakedPath(const std::string& sourcePath, const char* extension)
+    {
+        std::string path = sourcePath;
+        std::replace(path.begin(), path.end(), '\\', '/');
+        if (path.compare(0, std::strlen(SOURCE_DIRECTORY), SOURCE_DIRECTORY) == 0)
+            return BAKE_DIRECTORY + path.substr(std::strlen(SOURCE_DIRECTORY)) + extension;
+        return path + extension;
+    }
+
+    // size and contentHash of the source, false when it doesn't exist or is empty
+    static bool sourceKey(const std::string& sourcePath, uint64_t& size, uint64_t& hash)
+    {
+        MappedFile source;
+        if (!source.open(sourcePath))
+            return false;
+        size = (uint64_t)source.size();
+        hash = contentHash(source.data(), source.size());
+        return true;
+    }
+
+    // FNV-1a over 8-byte words rather than bytes, a few GB/s; it tells edits
+    // apart, it is not meant to resist anyone crafting collisions
+    static uint64_t contentHash(const unsigned char* data, size_t size)
+    {
+        const uint64_t prime = 0x100000001b3ull;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            hash = (hash ^ word) * prime;
+        }
+        for (; i < size; i++)
+            hash = (hash ^ data[i]) * prime;
+        return hash ^ (hash >> 29);
+    }
+
+    // Opens path.tmp for writing, creating the directories on the way. Write the
+    // file there and commit() it, so a half-written file is never read.
+    static bool openTemporary(const std::string& path, std::ofstream& file)
+    {
+        std::error_code ec;
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty())
+            std::filesystem::create_directories(parent, ec);
+        file.open(path + ".tmp", std::ios::binary | std::ios::trunc);
+        return (bool)file;
+    }
+
+    // closes file and moves path.tmp to path, false (and no file at path.tmp) when it failed
+    static bool commit(const std::string& path, std::ofstream& file)
+    {
+        bool written = (bool)file;
+        file.close();
+        std::error_code ec;
+        if (written)
+            std::filesystem::rename(path + ".tmp", path, ec);
+        if (!written || ec) {
+            std::filesystem::remove(path + ".tmp", ec);
+            return false;
+        }
+        return true;
+    }
+
+    static void writePadded(std::ofstream& file, const void* data, size_t size)
+    {
+        const char zeros[4] = { 0, 0, 0, 0 };
+        file.write((const char*)data, size);
+        file.write(zeros, (4 - size % 4) % 4);
+    }
+
+    // bounds-checked walk over a mapped file, next becomes null past the end
+    struct Reader {
+        const unsigned char* next;
+        const unsigned char* end;
+
+        template <typename T>
+        const T* take(size_t count)
+        {
+            if (next == nullptr || (size_t)(end - next) / sizeof(T) < count) {
+                next = nullptr;
+                return nullptr;
+            }
+            const T* result = (const T*)next;
+            next += count * sizeof(T);
+            return result;
+        }
+
+        // size bytes padded to 4
+        const unsigned char* takePadded(size_t size)
+        {
+            const unsigned char* result = next;
+            return take<uint32_t>((size + 3) / 4) ? result : nullptr;
+        }
+    };
+};
+
+#endif
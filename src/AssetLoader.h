@@ -0,0 +1,183 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads assets in the background while frames are drawn.
+//
+//     loader.load<TextureData>("sun", readSun, [](TextureData& data) { ... GL upload ... });
+//     ... every frame on the GL thread:
+//     loader.update(0.004);
+//
+// read() runs on a loader thread and returns the CPU payload (a parsed model,
+// decoded pixels), upload() gets it later on the thread that calls update(),
+// the one with the GL context. update() runs finished uploads until the frame's
+// time budget is used; an upload is never split, so one large asset can go over.
+//
+// The loads run on their own threads rather than the JobSystem: a load takes
+// many frames, and every job of the JobSystem must finish within its frame.
+//
+// The uploads capture their targets (a Model, the TextureStreamer), so the
+// loader is shut down before those go: either declare it after them, or call
+// shutdown() first.
+class AssetLoader
+{
+public:
+    AssetLoader(unsigned int threads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        start = Clock::now();
+        for (unsigned int i = 0; i < threads; i++)
+            workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+
+    ~AssetLoader()
+    {
+        shutdown();
+    }
+
+    // Drops the loads that haven't been uploaded yet, finishes the run() work
+    // already queued (it writes into memory someone is waiting on) and joins
+    // the threads. No upload runs after it returns; safe to call twice.
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            reads.erase(std::remove_if(reads.begin(), reads.end(), [](const Task& task) { return (bool)task.upload; }), reads.end());
+            uploads.clear();
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+        workers.clear();
+    }
+
+    template <typename T>
+    void load(const std::string& name, std::function<T()> read, std::function<void(T&)> upload)
+    {
+        std::shared_ptr<T> payload = std::make_shared<T>();
+        Task task;
+        task.name = name;
+        task.read = [payload, read]() { *payload = read(); };
+        task.upload = [payload, upload]() { upload(*payload); };
+        unfinished++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            reads.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Short work for a loader thread with nothing to upload, e.g. a copy into
+    // mapped memory. It goes ahead of the queued reads and isn't counted as an asset.
+    void run(std::function<void()> work)
+    {
+        Task task;
+        task.read = std::move(work);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            reads.push_front(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // GL thread: runs finished uploads for up to budget seconds, true once every asset is loaded
+    bool update(double budget)
+    {
+        Clock::time_point frameStart = Clock::now();
+        while (seconds(frameStart, Clock::now()) < budget) {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (uploads.empty())
+                    break;
+                task = std::move(uploads.front());
+                uploads.pop_front();
+            }
+            Clock::time_point uploadStart = Clock::now();
+            task.upload();
+            uploadTime += seconds(uploadStart, Clock::now());
+            if (task.readTime > slowestRead) {
+                slowestRead = task.readTime;
+                slowest = task.name;
+            }
+            unfinished--;
+            if (unfinished == 0)
+                std::cout << "assets loaded " << seconds(start, Clock::now()) << " s after start, " << uploadTime
+                          << " s of it GL uploads, slowest read " << slowest << " (" << slowestRead << " s)" << std::endl;
+        }
+        return unfinished == 0;
+    }
+
+    // GL thread: blocks until everything is loaded, for startup without the async path
+    void finish()
+    {
+        while (!update(1.0))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Task {
+        std::string name;
+        std::function<void()> read;
+        std::function<void()> upload;
+        double readTime = 0.0;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex; // guards both queues and quit
+    std::condition_variable wake;
+    std::deque<Task> reads;
+    std::deque<Task> uploads;
+    bool quit = false;
+    unsigned int unfinished = 0; // load() and update() both run on the GL thread
+
+    Clock::time_point start;
+    std::string slowest;
+    double slowestRead = 0.0;
+    double uploadTime = 0.0;
+
+    static double seconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+    void workerLoop()
+    {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return quit || !reads.empty(); });
+                if (reads.empty())
+                    return; // quit, and the run() work is done
+                task = std::move(reads.front());
+                reads.pop_front();
+            }
+            Clock::time_point readStart = Clock::now();
+            task.read();
+            task.readTime = seconds(readStart, Clock::now());
+            if (!task.upload)
+                continue;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!quit)
+                    uploads.push_back(std::move(task));
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+// Instruction set extensions of the CPU we run on, for picking a SIMD kernel
+// at runtime. AVX2 and FMA also require the OS to save the YMM registers.
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool fma = false;
+
+    static const CpuFeatures& get()
+    {
+        static CpuFeatures features = detect();
+        return features;
+    }
+
+private:
+    static CpuFeatures detect()
+    {
+        CpuFeatures f;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        f.sse2 = (info[3] >> 26) & 1;
+        bool avx = (info[2] >> 28) & 1;
+        bool osxsave = (info[2] >> 27) & 1;
+        bool ymmEnabled = osxsave && (_xgetbv(0) & 6) == 6;
+        f.fma = ((info[2] >> 12) & 1) && ymmEnabled;
+
+        if (maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            f.avx2 = avx && ymmEnabled && ((info[1] >> 5) & 1);
+        }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        f.sse2 = __builtin_cpu_supports("sse2");
+        f.avx2 = __builtin_cpu_supports("avx2");
+        f.fma = __builtin_cpu_supports("fma");
+#endif
+        return f;
+    }
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+#include <string>
+
+// View frustum as six planes (xyz - inward normal, w - distance), extracted
+// from a view-projection matrix. Shaders test against it with frustum.glsl.
+struct Frustum {
+    glm::vec4 planes[6]; // left, right, bottom, top, near, far
+
+    Frustum(const glm::mat4& viewProjection)
+    {
+        // Gribb-Hartmann, glm is column-major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+        const glm::mat4& m = viewProjection;
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++)
+            rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        for (int i = 0; i < 3; i++) {
+            planes[2 * i] = rows[3] + rows[i];
+            planes[2 * i + 1] = rows[3] - rows[i];
+        }
+    }
+
+    void setUniforms(Shader& shader) const
+    {
+        for (int i = 0; i < 6; i++)
+            shader.setVec4("frustumPlanes[" + std::to_string(i) + "]", planes[i]);
+    }
+};
+
+#endif
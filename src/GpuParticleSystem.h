@@ -0,0 +1,245 @@
+#ifndef GPU_PARTICLE_SYSTEM_H
+#define GPU_PARTICLE_SYSTEM_H
+
+#include <GLAD/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "ParticleSystem.h" // WindParticleParams
+#include "ParticleEmitter.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// must match WindParticle in particle.glsl
+struct GpuParticle {
+    glm::vec4 position; // xyz, w - remaining life, <= 0 when dead
+    glm::vec4 color;    // rgb, a - alpha
+    glm::vec4 params;   // x - seed, the phase of the side sway, yzw - velocity
+};
+
+// Wind particles simulated entirely on the GPU. The state lives in SSBOs and
+// never comes back to the CPU:
+//  - emit() pops free slots from a dead list (an atomic stack of indices),
+//  - update() ages and moves every particle, pushes the ones that die back to
+//    the dead list and appends the live ones to an alive list,
+//  - sort() orders the alive list back to front with a bitonic sort on the GPU,
+//    sized to the live particles through indirect dispatches,
+//  - draw() issues one indirect instanced draw over the alive list.
+// The CPU cost is the same for 500 particles as for hundreds of thousands.
+//
+// SSBO bindings: 5 - particles, 6 - dead list, 7 - alive list (starts with the indirect draw command),
+// 8 - sort keys, 10 - sort size and dispatches
+class GpuParticleSystem
+{
+public:
+    unsigned int capacity;
+    WindParticleParams params;
+
+    GpuParticleSystem(unsigned int capacity, const WindParticleParams& params)
+        : emitShader("resources/shaders/wind/particle_emit.cs.glsl", NULL, NULL, NULL),
+          updateShader("resources/shaders/wind/particle_update.cs.glsl", NULL, NULL, NULL),
+          sortLocalShader("resources/shaders/wind/particle_sort_local.cs.glsl", NULL, NULL, NULL),
+          sortGlobalShader("resources/shaders/wind/particle_sort_global.cs.glsl", NULL, NULL, NULL),
+          sortArgsShader("resources/shaders/wind/particle_sort_args.cs.glsl", NULL, NULL, NULL)
+    {
+        this->capacity = capacity;
+        this->params = params;
+
+        // the bitonic sort works on a power of two keys, at least one shared memory block
+        sortSize = SORT_BLOCK;
+        while (sortSize < capacity)
+            sortSize <<= 1;
+        glGenBuffers(1, &sortKeySSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, sortKeySSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sortSize * 2 * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+
+        // sortCount, then one DispatchIndirectCommand per pass of the schedule for sortSize
+        GLuint passes = 1;
+        for (GLuint k = 2 * SORT_BLOCK; k <= sortSize; k <<= 1)
+            for (GLuint j = k; j >= SORT_BLOCK; j >>= 1)
+                passes++; // the global steps j = k / 2 .. SORT_BLOCK, then the local merge
+        glGenBuffers(1, &sortDispatchSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, sortDispatchSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (1 + 3 * passes) * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+
+        // every particle starts dead, so every index starts in the dead list
+        std::vector<GpuParticle> particles(capacity, GpuParticle{ glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f) });
+        glGenBuffers(1, &particleSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GpuParticle), particles.data(), GL_DYNAMIC_DRAW);
+
+        std::vector<GLuint> deadList(capacity + 1);
+        deadList[0] = capacity;
+        for (unsigned int i = 0; i < capacity; i++)
+            deadList[i + 1] = i;
+        glGenBuffers(1, &deadListSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, deadListSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, deadList.size() * sizeof(GLuint), deadList.data(), GL_DYNAMIC_DRAW);
+
+        // DrawArraysIndirectCommand { count, instanceCount, first, baseInstance }, then the indices
+        std::vector<GLuint> aliveList(capacity + 4, 0);
+        aliveList[0] = 6;
+        glGenBuffers(1, &aliveListSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, aliveListSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, aliveList.size() * sizeof(GLuint), aliveList.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // the vertex shader builds the quads from gl_VertexID, the core profile still needs a VAO bound
+        glGenVertexArrays(1, &VAO);
+    }
+
+    // the pool that keeps every particle of emitter alive for its whole life:
+    // the full rate over one lifetime, plus a frame's budget of slack
+    static unsigned int capacityFor(const ParticleEmitter& emitter, float life)
+    {
+        return (unsigned int)std::ceil(emitter.rate * life) + emitter.frameBudget;
+    }
+
+    ~GpuParticleSystem()
+    {
+        glDeleteBuffers(1, &particleSSBO);
+        glDeleteBuffers(1, &deadListSSBO);
+        glDeleteBuffers(1, &aliveListSSBO);
+        glDeleteBuffers(1, &sortKeySSBO);
+        glDeleteBuffers(1, &sortDispatchSSBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // spawns up to count particles around emitterPos
+    void emit(unsigned int count, const glm::vec3& emitterPos)
+    {
+        if (count == 0)
+            return;
+        bindBuffers();
+        emitShader.use();
+        emitShader.setUInt("emitCount", count);
+        emitShader.setUInt("spawnSeed", params.spawnSeed);
+        emitShader.setUInt("spawnOffset", spawned);
+        emitShader.setVec3("emitterPos", emitterPos);
+        emitShader.setVec3("windDirection", params.windDirection);
+        emitShader.setFloat("particleLife", params.life);
+        glDispatchCompute((count + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        spawned += count;
+    }
+
+    void update(float deltaTime, float time)
+    {
+        // the update rebuilds the alive list from scratch
+        GLuint zero = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, aliveListSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), sizeof(GLuint), &zero);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        bindBuffers();
+        updateShader.use();
+        updateShader.setUInt("particleCount", capacity);
+        updateShader.setFloat("deltaTime", deltaTime);
+        updateShader.setFloat("time", time);
+        updateShader.setVec3("windDirection", params.windDirection);
+        updateShader.setFloat("windSpeed", params.windSpeed);
+        updateShader.setFloat("windWaveFrequency", params.windWaveFrequency);
+        updateShader.setFloat("sideAmplitude", params.sideAmplitude);
+        updateShader.setFloat("particleLife", params.life);
+        glDispatchCompute((capacity + 255) / 256, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    }
+
+    // Reorders the alive list far to near for view, call after update() and before draw().
+    // The sort covers n keys, the next power of two at or above the live count (at least
+    // SORT_BLOCK): log2(n) (log2(n) + 1) / 2 compare steps, the ones shorter than SORT_BLOCK
+    // in shared memory. n is only known on the GPU, so the passes are indirect dispatches
+    // that particle_sort_args.cs.glsl sizes; the merge stages above n get no work groups.
+    void sort(const glm::mat4& view)
+    {
+        bindBuffers();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, sortKeySSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, sortDispatchSSBO);
+
+        sortArgsShader.use();
+        sortArgsShader.setUInt("maxSortSize", sortSize);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, sortDispatchSSBO);
+        GLintptr pass = sizeof(GLuint); // the commands follow sortCount
+        const GLintptr passSize = 3 * sizeof(GLuint);
+
+        // keys from the alive list, then every block sorted on its own
+        sortLocalShader.use();
+        sortLocalShader.setMat4("view", view);
+        sortLocalShader.setUInt("mergeStage", 0);
+        glDispatchComputeIndirect(pass);
+        pass += passSize;
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        for (GLuint k = 2 * SORT_BLOCK; k <= sortSize; k <<= 1) {
+            sortGlobalShader.use();
+            sortGlobalShader.setUInt("k", k);
+            for (GLuint j = k / 2; j >= SORT_BLOCK; j >>= 1) {
+                sortGlobalShader.setUInt("j", j);
+                glDispatchComputeIndirect(pass);
+                pass += passSize;
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+            sortLocalShader.use();
+            sortLocalShader.setUInt("mergeStage", k);
+            glDispatchComputeIndirect(pass);
+            pass += passSize;
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    }
+
+    // shader is v_wind_particle_gpu.glsl + f_wind_particle.glsl, already in use
+    void draw(Shader& shader) const
+    {
+        bindBuffers();
+        shader.setFloat("particleScale", params.scale);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, aliveListSSBO);
+        glDrawArraysIndirect(GL_TRIANGLES, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    // prints the live particle count once per interval, reading it back waits for the update
+    void reportStats(double now, double interval = 2.0)
+    {
+        if (now - lastReport < interval)
+            return;
+        lastReport = now;
+
+        GLuint alive;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, aliveListSSBO);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), sizeof(GLuint), &alive);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        std::cout << "wind particles (GPU): " << alive << " / " << capacity << " alive" << std::endl;
+    }
+
+private:
+    static const GLuint SORT_BLOCK = 1024; // must match particle_sort.glsl
+
+    Shader emitShader;
+    Shader updateShader;
+    Shader sortLocalShader;
+    Shader sortGlobalShader;
+    Shader sortArgsShader;
+
+    GLuint particleSSBO, deadListSSBO, aliveListSSBO, sortKeySSBO, sortDispatchSSBO;
+    GLuint sortSize; // the largest sort, for the full capacity
+    GLuint VAO;
+    double lastReport = 0.0;
+    unsigned int spawned = 0; // spawns requested so far, the random stream of the next one
+
+    void bindBuffers() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, particleSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, deadListSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, aliveListSSBO);
+    }
+};
+
+#endif
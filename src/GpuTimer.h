@@ -0,0 +1,80 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GLAD/glad.h>
+
+#include <string>
+#include <iostream>
+
+// Measures GPU time of a section of the frame with GL_TIME_ELAPSED queries.
+// Two queries are used alternately so reading the result never stalls the pipeline,
+// the average is printed to the console every few seconds.
+class GpuTimer
+{
+public:
+    GpuTimer(const std::string& name, double reportInterval = 2.0)
+    {
+        this->name = name;
+        this->reportInterval = reportInterval;
+        glGenQueries(2, queries);
+    }
+
+    ~GpuTimer()
+    {
+        glDeleteQueries(2, queries);
+    }
+
+    void begin()
+    {
+        glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+    }
+
+    void end()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[current] = true;
+        current = 1 - current;
+
+        // result of the previous frame
+        if (pending[current]) {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[current], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &elapsed);
+                totalMs += elapsed / 1.0e6;
+                samples++;
+                pending[current] = false;
+            }
+        }
+    }
+
+    double averageMs() const
+    {
+        return samples > 0 ? totalMs / samples : 0.0;
+    }
+
+    // prints and resets the average once per reportInterval seconds
+    void report(double now)
+    {
+        if (now - lastReport < reportInterval || samples == 0)
+            return;
+        std::cout << name << ": " << averageMs() << " ms (" << samples << " frames)" << std::endl;
+        lastReport = now;
+        totalMs = 0.0;
+        samples = 0;
+    }
+
+private:
+    std::string name;
+    GLuint queries[2];
+    bool pending[2] = { false, false };
+    int current = 0;
+
+    double totalMs = 0.0;
+    unsigned int samples = 0;
+    double reportInterval;
+    double lastReport = 0.0;
+};
+
+#endif
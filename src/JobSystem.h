@@ -0,0 +1,345 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for the CPU work of a frame.
+//
+//     JobSystem::JobId a = jobs.parallelFor("particles", 0, n, 1024, updateRange);
+//     JobSystem::JobId b = jobs.add("instances", fillInstances, { a });
+//     ... GL work on the main thread ...
+//     jobs.wait(b);
+//     jobs.waitFrame(); // end of the frame, every job is done and the ids are reset
+//
+// Every worker owns a queue: it pops its own jobs from the back and steals from
+// the front of the others when it runs dry. A job is queued once all of its
+// dependencies finished. The main thread is worker 0 and runs jobs while it
+// waits, so with no worker threads everything still runs, just serially.
+//
+// Jobs are added only from the main thread, job ids are valid until waitFrame().
+// Every job execution is recorded per worker, reportStats() prints the load of
+// each worker and captureTrace() writes one frame in the chrome://tracing format.
+class JobSystem
+{
+public:
+    typedef unsigned int JobId;
+
+    JobSystem(unsigned int workerThreads = std::max(1u, std::thread::hardware_concurrency()) - 1)
+    {
+        for (unsigned int i = 0; i < workerThreads + 1; i++)
+            workers.emplace_back(new Worker());
+        workerIndex() = 0;
+        frameStart = Clock::now();
+        for (unsigned int i = 1; i < workers.size(); i++)
+            workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+    }
+
+    ~JobSystem()
+    {
+        waitFrame();
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (unsigned int i = 1; i < workers.size(); i++)
+            workers[i]->thread.join();
+    }
+
+    // threads running jobs, the main thread included
+    unsigned int threadCount() const
+    {
+        return (unsigned int)workers.size();
+    }
+
+    JobId add(const char* name, std::function<void()> work, std::initializer_list<JobId> dependencies = {})
+    {
+        JobId id = create(name, std::move(work));
+        for (JobId dependency : dependencies)
+            dependOn(id, dependency);
+        release(id);
+        return id;
+    }
+
+    // work(first, last) over [begin, end) in ranges of grain elements, the returned
+    // job finishes after all of them
+    JobId parallelFor(const char* name, unsigned int begin, unsigned int end, unsigned int grain,
+                      std::function<void(unsigned int, unsigned int)> work, std::initializer_list<JobId> dependencies = {})
+    {
+        std::shared_ptr<std::function<void(unsigned int, unsigned int)>> shared =
+            std::make_shared<std::function<void(unsigned int, unsigned int)>>(std::move(work));
+        std::vector<JobId> ranges;
+        for (unsigned int first = begin; first < end; first += grain) {
+            unsigned int last = std::min(end, first + grain);
+            ranges.push_back(add(name, [shared, first, last]() { (*shared)(first, last); }, dependencies));
+        }
+
+        JobId join = create(name, []() {});
+        for (JobId range : ranges)
+            dependOn(join, range);
+        if (ranges.empty())
+            for (JobId dependency : dependencies)
+                dependOn(join, dependency);
+        release(join);
+        return join;
+    }
+
+    // runs other jobs until the job is done
+    void wait(JobId id)
+    {
+        Job& job = jobs[id];
+        while (!job.done)
+            helpOrYield();
+    }
+
+    // waits for every job of the frame and starts the next one
+    void waitFrame()
+    {
+        while (unfinished > 0)
+            helpOrYield();
+
+        double frameLength = seconds(Clock::now());
+        statsTime += frameLength;
+        for (std::unique_ptr<Worker>& worker : workers) {
+            for (const TraceEvent& event : worker->trace)
+                worker->busyTime += event.end - event.start;
+            worker->jobCount += (unsigned int)worker->trace.size();
+        }
+        if (!tracePath.empty()) {
+            writeTrace(tracePath.c_str());
+            tracePath.clear();
+        }
+
+        for (std::unique_ptr<Worker>& worker : workers)
+            worker->trace.clear();
+        jobs.clear();
+        frameStart = Clock::now();
+    }
+
+    // writes the jobs of the current frame to path at the next waitFrame()
+    void captureTrace(const char* path)
+    {
+        tracePath = path;
+    }
+
+    // prints the busy share of every thread and how many jobs it ran since the last report
+    void reportStats(double now, double interval = 2.0)
+    {
+        if (now - lastReport < interval)
+            return;
+        lastReport = now;
+        if (statsTime <= 0.0)
+            return;
+
+        std::cout << "jobs, " << workers.size() << " threads busy:";
+        for (std::unique_ptr<Worker>& worker : workers) {
+            std::cout << " " << (int)(100.0 * worker->busyTime / statsTime) << "% (" << worker->jobCount << ")";
+            worker->busyTime = 0.0;
+            worker->jobCount = 0;
+        }
+        std::cout << std::endl;
+        statsTime = 0.0;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Job {
+        const char* name;
+        std::function<void()> work;
+        std::atomic<int> pendingDependencies;
+        std::atomic<bool> done{ false };
+        std::mutex mutex; // guards dependents and the transition to done
+        std::vector<Job*> dependents;
+    };
+
+    // seconds since the frame started
+    struct TraceEvent {
+        const char* name;
+        double start, end;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<Job*> queue;
+        std::vector<TraceEvent> trace; // written only by the worker's own thread
+        double busyTime = 0.0;
+        unsigned int jobCount = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::deque<Job> jobs; // elements never move while the frame runs
+    std::atomic<int> unfinished{ 0 };
+    std::atomic<int> queued{ 0 };
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool quit = false;
+
+    Clock::time_point frameStart;
+    std::string tracePath;
+    double statsTime = 0.0;
+    double lastReport = 0.0;
+
+    static unsigned int& workerIndex()
+    {
+        static thread_local unsigned int index = 0;
+        return index;
+    }
+
+    double seconds(Clock::time_point time) const
+    {
+        return std::chrono::duration<double>(time - frameStart).count();
+    }
+
+    // a new job holds one extra dependency until release(), so it cannot be
+    // queued while its dependencies are still being added
+    JobId create(const char* name, std::function<void()> work)
+    {
+        JobId id = (JobId)jobs.size();
+        jobs.emplace_back();
+        Job& job = jobs.back();
+        job.name = name;
+        job.work = std::move(work);
+        job.pendingDependencies = 1;
+        unfinished++;
+        return id;
+    }
+
+    void dependOn(JobId id, JobId dependency)
+    {
+        Job& before = jobs[dependency];
+        std::lock_guard<std::mutex> lock(before.mutex);
+        if (!before.done) {
+            before.dependents.push_back(&jobs[id]);
+            jobs[id].pendingDependencies++;
+        }
+    }
+
+    void release(JobId id)
+    {
+        if (--jobs[id].pendingDependencies == 0)
+            schedule(&jobs[id]);
+    }
+
+    void schedule(Job* job)
+    {
+        Worker& worker = *workers[workerIndex()];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.queue.push_back(job);
+        }
+        queued++;
+        {
+            // a worker going to sleep has either seen queued or gets the notify
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // newest job of our own queue, otherwise the oldest job of another
+    Job* findJob(unsigned int index)
+    {
+        {
+            Worker& own = *workers[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.queue.empty()) {
+                Job* job = own.queue.back();
+                own.queue.pop_back();
+                queued--;
+                return job;
+            }
+        }
+        for (unsigned int i = 1; i < workers.size(); i++) {
+            Worker& victim = *workers[(index + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.queue.empty()) {
+                Job* job = victim.queue.front();
+                victim.queue.pop_front();
+                queued--;
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void run(Job* job, unsigned int index)
+    {
+        double start = seconds(Clock::now());
+        job->work();
+        workers[index]->trace.push_back({ job->name, start, seconds(Clock::now()) });
+
+        std::vector<Job*> dependents;
+        {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->done = true;
+            dependents.swap(job->dependents);
+        }
+        for (Job* dependent : dependents)
+            if (--dependent->pendingDependencies == 0)
+                schedule(dependent);
+        // last, waitFrame() may free the job as soon as this reaches 0
+        unfinished--;
+    }
+
+    void helpOrYield()
+    {
+        Job* job = findJob(0);
+        if (job != nullptr)
+            run(job, 0);
+        else
+            std::this_thread::yield();
+    }
+
+    void workerLoop(unsigned int index)
+    {
+        workerIndex() = index;
+        while (true) {
+            Job* job = findJob(index);
+            if (job != nullptr) {
+                run(job, index);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this]() { return quit || queued > 0; });
+            if (quit)
+                return;
+        }
+    }
+
+    void writeTrace(const char* path) const
+    {
+        std::ofstream file(path);
+        if (!file) {
+            std::cout << "ERROR::JOB_SYSTEM::TRACE_NOT_WRITTEN: " << path << std::endl;
+            return;
+        }
+        file << "[";
+        bool first = true;
+        for (unsigned int i = 0; i < workers.size(); i++) {
+            for (const TraceEvent& event : workers[i]->trace) {
+                file << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << i
+                     << ",\"ts\":" << event.start * 1e6 << ",\"dur\":" << (event.end - event.start) * 1e6 << "}";
+                first = false;
+            }
+        }
+        file << "\n]\n";
+        std::cout << "job trace written to " << path << std::endl;
+    }
+};
+
+#endif
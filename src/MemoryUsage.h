@@ -0,0 +1,78 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h> // K32GetProcessMemoryInfo, in kernel32 since Windows 7
+#endif
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Resident memory of the process, to measure what loading something costs:
+//
+//     MemoryUsage before = MemoryUsage::read();
+//     ... load ...
+//     MemoryUsage::read().report("models", before);
+//
+// From VmRSS and VmHWM in /proc/self/status on Linux, the working set and its
+// peak on Windows; zero where neither is available.
+struct MemoryUsage
+{
+    size_t residentKB = 0;
+    size_t peakKB = 0; // highest resident size so far
+
+    static MemoryUsage read()
+    {
+        MemoryUsage usage;
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            usage.residentKB = counters.WorkingSetSize / 1024;
+            usage.peakKB = counters.PeakWorkingSetSize / 1024;
+        }
+#else
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            std::istringstream fields(line);
+            std::string key;
+            size_t value = 0;
+            fields >> key >> value; // "VmRSS:    123456 kB"
+            if (key == "VmRSS:")
+                usage.residentKB = value;
+            else if (key == "VmHWM:")
+                usage.peakKB = value;
+        }
+#endif
+        return usage;
+    }
+
+    bool available() const
+    {
+        return residentKB > 0;
+    }
+
+    // prints this usage and how far it is from before
+    void report(const std::string& label, const MemoryUsage& before) const
+    {
+        if (!available() || !before.available()) {
+            std::cout << "memory after " << label << ": not available on this platform" << std::endl;
+            return;
+        }
+        std::cout << "memory after " << label << ": resident " << residentKB / 1024.0 << " MB ("
+                  << ((long long)residentKB - (long long)before.residentKB) / 1024.0 << " MB), peak " << peakKB / 1024.0
+                  << " MB (" << ((long long)peakKB - (long long)before.peakKB) / 1024.0 << " MB)" << std::endl;
+    }
+};
+
+#endif
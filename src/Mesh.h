@@ -25,20 +25,86 @@ struct Texture {
     string path;  // we store the path of the texture to compare with other textures
 };
 
+// Owns its VAO and buffers, so it can be moved but not copied. The vertices
+// and indices live on the GPU; the CPU copy is only kept when keepGeometry is
+// set, e.g. for picking, and can be dropped later with releaseGeometry().
 class Mesh {
 public:
-    vector<Vertex>       vertices;
+    vector<Vertex>       vertices; // empty unless the geometry was kept
     vector<unsigned int> indices;
     vector<Texture>      textures;
 
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // takes the arrays over, move them in
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool keepGeometry = false)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+        if (!keepGeometry)
+            releaseGeometry();
+    }
+
+    // uploads straight from the arrays, e.g. a mapped MeshCache file
+    Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, vector<Texture> textures, bool keepGeometry = false)
+    {
+        if (keepGeometry) {
+            this->vertices.assign(vertices, vertices + vertexCount);
+            this->indices.assign(indices, indices + indexCount);
+        }
+        this->textures = std::move(textures);
+
+        setupMesh(vertices, vertexCount, indices, indexCount);
+    }
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    Mesh(Mesh&& other) noexcept
+        : vertices(std::move(other.vertices)), indices(std::move(other.indices)), textures(std::move(other.textures)),
+          VAO(other.VAO), VBO(other.VBO), EBO(other.EBO), vertexCount(other.vertexCount), indexCount(other.indexCount)
+    {
+        other.VAO = other.VBO = other.EBO = 0;
+        other.vertexCount = other.indexCount = 0;
+    }
+
+    Mesh& operator=(Mesh&& other) noexcept
+    {
+        if (this != &other) {
+            deleteBuffers();
+            vertices = std::move(other.vertices);
+            indices = std::move(other.indices);
+            textures = std::move(other.textures);
+            VAO = other.VAO;
+            VBO = other.VBO;
+            EBO = other.EBO;
+            vertexCount = other.vertexCount;
+            indexCount = other.indexCount;
+            other.VAO = other.VBO = other.EBO = 0;
+            other.vertexCount = other.indexCount = 0;
+        }
+        return *this;
+    }
+
+    // the textures belong to the Model, they are shared between its meshes
+    ~Mesh()
+    {
+        deleteBuffers();
+    }
+
+    // frees the CPU copy of the geometry, the mesh still draws
+    void releaseGeometry()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+    }
+
+    // bytes of vertices and indices on the GPU
+    size_t geometrySize() const
+    {
+        return vertexCount * sizeof(Vertex) + indexCount * sizeof(unsigned int);
     }
 
     void Draw(Shader& shader)
@@ -62,27 +128,30 @@ public:
         glActiveTexture(GL_TEXTURE0);
 
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
 
         glActiveTexture(GL_TEXTURE0);
     }
 
 private:
-    unsigned int VAO, VBO, EBO;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    GLsizei vertexCount = 0, indexCount = 0;
 
-    void setupMesh()
+    void setupMesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount)
     {
+        this->vertexCount = (GLsizei)vertexCount;
+        this->indexCount = (GLsizei)indexCount;
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData, GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
 
         // vertex Positions
         glEnableVertexAttribArray(0);
@@ -94,6 +163,16 @@ private:
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
     }
+
+    void deleteBuffers()
+    {
+        if (VAO == 0)
+            return;
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
 };
 #endif
 
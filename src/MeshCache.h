@@ -0,0 +1,244 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <assimp/include/assimp/Importer.hpp>
+#include <assimp/include/assimp/scene.h>
+#include <assimp/include/assimp/postprocess.h>
+
+#include "AssetCache.h"
+#include "Mesh.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A texture of a material, by file name relative to the model
+struct TextureRef {
+    std::string type; // texture_diffuse, texture_specular
+    std::string path;
+};
+
+// One mesh of an imported model, before it is uploaded
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<TextureRef> textures;
+};
+
+// A mesh inside a mapped cache file, the arrays point into the mapping
+struct MeshView {
+    const Vertex* vertices;
+    uint32_t vertexCount;
+    const unsigned int* indices;
+    uint32_t indexCount;
+    std::vector<TextureRef> textures;
+};
+
+// Binary cache of the Assimp import of a model, so the import runs once per
+// asset instead of on every start.
+//
+// The cache is the baked file <source>.meshcache (see AssetCache) and holds the
+// post-processed vertex and index arrays of every mesh plus the texture names
+// of its material. It is valid only for the format VERSION, the post-process
+// flags and the size and content hash of the source it was baked from;
+// anything else is treated as a miss and the model is imported again. The
+// .mtl file is not part of the key, rebake with --force after editing materials.
+//
+// Layout, little endian, every block 4-byte aligned:
+//     CacheHeader
+//     per mesh: vertex count, index count, texture count,
+//               per texture: type length, path length, both strings padded to 4 bytes,
+//               vertices (Vertex), indices (uint32)
+class MeshCache
+{
+public:
+    static constexpr uint32_t VERSION = 2;
+
+    // the post-processing of every model import; the vertex cache reordering
+    // costs import time only, which the bake pays once
+    static constexpr unsigned int POST_PROCESS = aiProcess_Triangulate |
+                                                 aiProcess_FlipUVs |
+                                                 aiProcess_CalcTangentSpace |
+                                                 aiProcess_JoinIdenticalVertices |
+                                                 aiProcess_ImproveCacheLocality;
+
+    static std::string cachePath(const std::string& sourcePath)
+    {
+        return AssetCache::bakedPath(sourcePath, ".meshcache");
+    }
+
+    // true when the cache of sourcePath exists and matches the source
+    static bool isCurrent(const std::string& sourcePath, unsigned int postProcess)
+    {
+        MappedFile file;
+        return readHeader(sourcePath, postProcess, file) != nullptr;
+    }
+
+    // Imports the source with Assimp, false with error set when it fails
+    static bool import(const std::string& sourcePath, unsigned int postProcess, std::vector<MeshData>& meshes, std::string& error)
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(sourcePath, postProcess);
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+            error = importer.GetErrorString();
+            return false;
+        }
+        meshes.clear();
+        addNode(scene->mRootNode, scene, meshes);
+        return true;
+    }
+
+    // Writes the cache of sourcePath
+    static bool write(const std::string& sourcePath, unsigned int postProcess, const std::vector<MeshData>& meshes)
+    {
+        CacheHeader header;
+        if (!AssetCache::sourceKey(sourcePath, header.sourceSize, header.sourceHash))
+            return false;
+        header.postProcess = postProcess;
+        header.meshCount = (uint32_t)meshes.size();
+
+        std::string path = cachePath(sourcePath);
+        std::ofstream file;
+        if (!AssetCache::openTemporary(path, file))
+            return false;
+        file.write((const char*)&header, sizeof(header));
+        for (const MeshData& mesh : meshes) {
+            uint32_t counts[3] = { (uint32_t)mesh.vertices.size(), (uint32_t)mesh.indices.size(), (uint32_t)mesh.textures.size() };
+            file.write((const char*)counts, sizeof(counts));
+            for (const TextureRef& texture : mesh.textures) {
+                uint32_t lengths[2] = { (uint32_t)texture.type.size(), (uint32_t)texture.path.size() };
+                file.write((const char*)lengths, sizeof(lengths));
+                AssetCache::writePadded(file, texture.type.data(), texture.type.size());
+                AssetCache::writePadded(file, texture.path.data(), texture.path.size());
+            }
+            file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+            file.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+        }
+        return AssetCache::commit(path, file);
+    }
+
+    // Maps the cache of sourcePath and points meshes into it, false when there
+    // is no cache or it is stale or damaged. The views are valid while file is open.
+    static bool load(const std::string& sourcePath, unsigned int postProcess, MappedFile& file, std::vector<MeshView>& meshes)
+    {
+        const CacheHeader* header = readHeader(sourcePath, postProcess, file);
+        if (header == nullptr)
+            return false;
+
+        AssetCache::Reader reader{ file.data() + sizeof(CacheHeader), file.data() + file.size() };
+        meshes.clear();
+        for (uint32_t m = 0; m < header->meshCount; m++) {
+            const uint32_t* counts = reader.take<uint32_t>(3);
+            if (counts == nullptr)
+                break;
+            MeshView mesh;
+            mesh.vertexCount = counts[0];
+            mesh.indexCount = counts[1];
+            for (uint32_t t = 0; t < counts[2]; t++) {
+                const uint32_t* lengths = reader.take<uint32_t>(2);
+                const char* type = lengths ? (const char*)reader.takePadded(lengths[0]) : nullptr;
+                const char* path = type ? (const char*)reader.takePadded(lengths[1]) : nullptr;
+                if (path == nullptr) {
+                    reader.next = nullptr;
+                    break;
+                }
+                mesh.textures.push_back({ std::string(type, lengths[0]), std::string(path, lengths[1]) });
+            }
+            mesh.vertices = reader.take<Vertex>(mesh.vertexCount);
+            mesh.indices = reader.take<unsigned int>(mesh.indexCount);
+            if (mesh.vertices == nullptr || mesh.indices == nullptr)
+                break;
+            meshes.push_back(std::move(mesh));
+        }
+
+        if (meshes.size() != header->meshCount) {
+            std::cout << "ERROR::MESH_CACHE::DAMAGED: " << cachePath(sourcePath) << std::endl;
+            meshes.clear();
+            file.close();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct CacheHeader {
+        char magic[4] = { 'M', 'N', 'W', 'M' };
+        uint32_t version = VERSION;
+        uint64_t sourceSize = 0;
+        uint64_t sourceHash = 0;
+        uint32_t postProcess = 0;
+        uint32_t meshCount = 0;
+    };
+    static_assert(sizeof(CacheHeader) == 32, "the header is written as is");
+    static_assert(sizeof(Vertex) == 8 * sizeof(float), "vertices are written as is");
+
+    // maps the cache and checks its header against the source, null when it doesn't match
+    static const CacheHeader* readHeader(const std::string& sourcePath, unsigned int postProcess, MappedFile& file)
+    {
+        CacheHeader expected;
+        if (!AssetCache::sourceKey(sourcePath, expected.sourceSize, expected.sourceHash))
+            return nullptr;
+        if (!file.open(cachePath(sourcePath)))
+            return nullptr;
+
+        AssetCache::Reader reader{ file.data(), file.data() + file.size() };
+        const CacheHeader* header = reader.take<CacheHeader>(1);
+        if (header == nullptr || std::memcmp(header->magic, expected.magic, sizeof(header->magic)) != 0 ||
+            header->version != expected.version || header->postProcess != postProcess ||
+            header->sourceSize != expected.sourceSize || header->sourceHash != expected.sourceHash) {
+            file.close();
+            return nullptr;
+        }
+        return header;
+    }
+
+    static void addNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshes)
+    {
+        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+            meshes.push_back(convert(scene->mMeshes[node->mMeshes[i]], scene));
+        for (unsigned int i = 0; i < node->mNumChildren; i++)
+            addNode(node->mChildren[i], scene, meshes);
+    }
+
+    static MeshData convert(aiMesh* mesh, const aiScene* scene)
+    {
+        MeshData data;
+        data.vertices.reserve(mesh->mNumVertices);
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+            Vertex vertex;
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            vertex.Normal = glm::vec3(0.0f);
+            if (mesh->HasNormals())
+                vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+            // only the first of the up to 8 texture coordinate sets is used
+            vertex.TexCoords = glm::vec2(0.0f);
+            if (mesh->mTextureCoords[0])
+                vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+            data.vertices.push_back(vertex);
+        }
+
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+            const aiFace& face = mesh->mFaces[i];
+            for (unsigned int j = 0; j < face.mNumIndices; j++)
+                data.indices.push_back(face.mIndices[j]);
+        }
+
+        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        addTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data.textures);
+        addTextures(material, aiTextureType_SPECULAR, "texture_specular", data.textures);
+        return data;
+    }
+
+    static void addTextures(aiMaterial* material, aiTextureType type, const char* typeName, std::vector<TextureRef>& textures)
+    {
+        for (unsigned int i = 0; i < material->GetTextureCount(type); i++) {
+            aiString path;
+            material->GetTexture(type, i, &path);
+            textures.push_back({ typeName, path.C_Str() });
+        }
+    }
+};
+
+#endif
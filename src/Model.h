@@ -5,21 +5,36 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <stb_image.h>
-#include <assimp/include/assimp/Importer.hpp>
-#include <assimp/include/assimp/scene.h>
-#include <assimp/include/assimp/postprocess.h>
 
+#include <MeshCache.h>
+#include <TextureCache.h>
+#include <AssetLoader.h>
+#include <TextureStreamer.h>
 #include <Mesh.h>
 #include <Shader.h> 
 
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
+unsigned int TextureFromData(TextureData data, TextureStreamer* streamer = nullptr);
+
+// A model read for upload, see Model::read
+struct ModelData {
+    string path;
+    const char* source = "";           // where the meshes came from, the mesh cache or Assimp
+    std::unique_ptr<MappedFile> cacheFile;
+    vector<MeshView> views;            // from the mesh cache, point into cacheFile
+    vector<MeshData> imported;         // from Assimp
+    vector<TextureData> textures;      // every texture of the meshes, once
+    double readTime = 0.0;
+};
 
 class Model
 {
@@ -28,10 +43,17 @@ public:
     vector<Mesh> meshes;
     string directory;
     bool gammaCorrection;
+    bool keepGeometry = false; // the meshes keep a CPU copy of their vertices and indices, set before the load
+
+    // empty until upload(), see loadAsync()
+    Model()
+    {
+    }
 
     Model(char* path)
     {
-        loadModel(path);
+        ModelData data = read(path);
+        upload(data);
     }
 
     void Draw(Shader& shader)
@@ -40,111 +62,99 @@ public:
             meshes[i].Draw(shader);
     }
 
-private:
-    void loadModel(string path)
+    // Reads the model in the background, it draws nothing until the loader
+    // has run its upload and its textures fill in as the streamer gets to
+    // them. The upload points at the model, so the loader is declared after
+    // it or shut down before it goes, see AssetLoader::shutdown.
+    void loadAsync(AssetLoader& loader, TextureStreamer& streamer, const string& path)
     {
-        Assimp::Importer import;
-        const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | 
-                                                     aiProcess_FlipUVs |
-                                                     aiProcess_CalcTangentSpace |
-                                                     aiProcess_JoinIdenticalVertices);
-
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-        {
-            cout << "ERROR::ASSIMP::" << import.GetErrorString() << endl;
-            return;
-        }
-        directory = path.substr(0, path.find_last_of('/'));
-
-        processNode(scene->mRootNode, scene);
+        loader.load<ModelData>(path, [path]() { return read(path); }, [this, &streamer](ModelData& data) { upload(data, &streamer); });
     }
 
-    void processNode(aiNode* node, const aiScene* scene)
+    // The CPU half of the load, safe on any thread. Uses the baked MeshCache
+    // when it is up to date, Assimp runs only when it is missing or stale and
+    // then writes a new one. The textures are decoded here too.
+    static ModelData read(const string& path)
     {
-        // process all the node's meshes (if any)
-        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ModelData data;
+        data.path = path;
+        string directory = path.substr(0, path.find_last_of('/'));
+
+        data.cacheFile.reset(new MappedFile());
+        if (MeshCache::load(path, MeshCache::POST_PROCESS, *data.cacheFile, data.views))
         {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            data.source = "mesh cache";
+            for (const MeshView& view : data.views)
+                readTextures(view.textures, directory, data.textures);
         }
-        // then do the same for each of its children
-        for (unsigned int i = 0; i < node->mNumChildren; i++)
+        else
         {
-            processNode(node->mChildren[i], scene);
+            data.cacheFile.reset();
+            string error;
+            if (!MeshCache::import(path, MeshCache::POST_PROCESS, data.imported, error))
+            {
+                cout << "ERROR::ASSIMP::" << error << endl;
+                return data;
+            }
+            data.source = "Assimp";
+            if (!MeshCache::write(path, MeshCache::POST_PROCESS, data.imported))
+                cout << "ERROR::MESH_CACHE::NOT_WRITTEN: " << MeshCache::cachePath(path) << endl;
+            for (const MeshData& mesh : data.imported)
+                readTextures(mesh.textures, directory, data.textures);
         }
+        data.readTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return data;
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    // The GL half of the load, on the thread with the context; the textures
+    // are queued on streamer when there is one, uploaded right away otherwise
+    void upload(ModelData& data, TextureStreamer* streamer = nullptr)
     {
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
-
-        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-        {
-            Vertex vertex;
-            glm::vec3 vector; 
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
-
-            if (mesh->HasNormals())
-            {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.Normal = vector;
-            }
-
-            if (mesh->mTextureCoords[0]) 
-            {
-                glm::vec2 vec;
-                // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
-                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-            }
-            else
-                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
-        }
-        // now walk through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
-        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-        {
-            aiFace face = mesh->mFaces[i];
-            // retrieve all indices of the face and store them in the indices vector
-            for (unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
-        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        directory = data.path.substr(0, data.path.find_last_of('/'));
+        meshes.reserve(meshes.size() + data.views.size() + data.imported.size());
+        for (const MeshView& view : data.views)
+            meshes.emplace_back(view.vertices, view.vertexCount, view.indices, view.indexCount, loadTextures(view.textures, data, streamer), keepGeometry);
+        // the imported arrays move into the meshes, which free them once uploaded
+        for (MeshData& mesh : data.imported)
+            meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), loadTextures(mesh.textures, data, streamer), keepGeometry);
+        glBindVertexArray(0); // the meshes leave theirs bound
+
+        // cold (Assimp) and warm (mesh cache) loads, textures included
+        double uploadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t geometrySize = 0;
+        for (const Mesh& mesh : meshes)
+            geometrySize += mesh.geometrySize();
+        cout << "model " << data.path << " read from " << data.source << " in " << data.readTime * 1000.0
+             << " ms, uploaded in " << uploadTime * 1000.0 << " ms, " << geometrySize / 1024 << " KB of geometry"
+             << (keepGeometry ? " kept on the CPU" : " on the GPU only") << endl;
+    }
 
-        if (mesh->mMaterialIndex >= 0)
+private:
+    static void readTextures(const vector<TextureRef>& references, const string& directory, vector<TextureData>& textures)
+    {
+        for (const TextureRef& reference : references)
         {
-            aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-            vector<Texture> diffuseMaps = loadMaterialTextures(material,
-                aiTextureType_DIFFUSE, "texture_diffuse");
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-            vector<Texture> specularMaps = loadMaterialTextures(material,
-                aiTextureType_SPECULAR, "texture_specular");
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+            string path = directory + '/' + reference.path;
+            bool known = false;
+            for (const TextureData& texture : textures)
+                known = known || texture.path == path;
+            if (!known)
+                textures.push_back(TextureCache::read(path, true));
         }
-
-        return Mesh(vertices, indices, textures);
     }
 
-    vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
+    // textures are created once per model and shared between its meshes
+    vector<Texture> loadTextures(const vector<TextureRef>& references, ModelData& data, TextureStreamer* streamer)
     {
         vector<Texture> textures;
-        for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+        for (const TextureRef& reference : references)
         {
-            aiString str;
-            mat->GetTexture(type, i, &str);
             bool skip = false;
             for (unsigned int j = 0; j < textures_loaded.size(); j++)
             {
-                if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
+                if (textures_loaded[j].path == reference.path)
                 {
                     textures.push_back(textures_loaded[j]);
                     skip = true;
@@ -154,9 +164,12 @@ private:
             if (!skip)
             {   // if texture hasn't been loaded already, load it
                 Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
+                texture.id = 0;
+                for (TextureData& textureData : data.textures)
+                    if (textureData.path == directory + '/' + reference.path)
+                        texture.id = TextureFromData(std::move(textureData), streamer);
+                texture.type = reference.type;
+                texture.path = reference.path;
                 textures.push_back(texture);
                 textures_loaded.push_back(texture); // add to loaded textures
             }
@@ -167,41 +180,23 @@ private:
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
 {
-    string filename = string(path);
-    filename = directory + '/' + filename;
+    return TextureFromData(TextureCache::read(directory + '/' + string(path), true));
+}
 
+// baked levels or the decoded image of TextureCache::read, a texture is created even if it failed to load
+unsigned int TextureFromData(TextureData data, TextureStreamer* streamer)
+{
     unsigned int textureID;
     glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (streamer != nullptr)
+        streamer->stream(textureID, GL_TEXTURE_2D, std::move(data), true);
     else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
+        TextureCache::upload(GL_TEXTURE_2D, data, true);
     return textureID;
 }
 
@@ -0,0 +1,187 @@
+#ifndef OCEAN_FFT_H
+#define OCEAN_FFT_H
+
+#include <GLAD/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "OceanSpectrum.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// GPU Tessendorf ocean. The spectrum is initialised once, then every frame it
+// is evolved in time and brought back to heights with a 2D inverse FFT, so the
+// cost is O(N^2 log N) regardless of how many wave components the spectrum has.
+// OceanSpectrum is the CPU reference of the same pipeline.
+//
+// The water kernels sample the result through wave.glsl (see bindHeightField).
+//
+// SSBO bindings: 2 - h0 spectrum, 3 - h(k, t), heights after update()
+// The CPU gets the heights back through requestHeights() / readHeights().
+class OceanFFT
+{
+public:
+    // must match FFT_SIZE in ocean_fft.cs.glsl
+    static const unsigned int FFT_SIZE = 256;
+
+    OceanParams params;
+
+    OceanFFT(const OceanParams& params)
+        : spectrumShader("resources/shaders/water/ocean_spectrum.cs.glsl", NULL, NULL, NULL),
+          evolveShader("resources/shaders/water/ocean_evolve.cs.glsl", NULL, NULL, NULL),
+          fftShader("resources/shaders/water/ocean_fft.cs.glsl", NULL, NULL, NULL)
+    {
+        this->params = params;
+        if (this->params.size != FFT_SIZE) {
+            std::cout << "OceanFFT: only " << FFT_SIZE << "x" << FFT_SIZE << " is supported, ignoring size " << params.size << std::endl;
+            this->params.size = FFT_SIZE;
+        }
+
+        unsigned int count = FFT_SIZE * FFT_SIZE;
+
+        glGenBuffers(1, &spectrumSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, spectrumSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+
+        glGenBuffers(1, &heightSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, heightSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::vec2), nullptr, GL_DYNAMIC_DRAW);
+
+        glGenBuffers(1, &readbackBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(glm::vec2), nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        readbackFence = 0;
+
+        initSpectrum();
+    }
+
+    ~OceanFFT()
+    {
+        glDeleteBuffers(1, &spectrumSSBO);
+        glDeleteBuffers(1, &heightSSBO);
+        glDeleteBuffers(1, &readbackBuffer);
+        if (readbackFence != 0)
+            glDeleteSync(readbackFence);
+    }
+
+    // recomputes h0(k), call after changing params
+    void initSpectrum()
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, spectrumSSBO);
+
+        spectrumShader.use();
+        spectrumShader.setUInt("fftSize", FFT_SIZE);
+        spectrumShader.setFloat("patchSize", params.patchSize);
+        spectrumShader.setFloat("windSpeed", params.windSpeed);
+        spectrumShader.setVec2("windDir", params.windDir);
+        spectrumShader.setFloat("amplitude", params.amplitude);
+        spectrumShader.setUInt("seed", params.seed);
+        glDispatchCompute(FFT_SIZE / 16, FFT_SIZE / 16, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // evolves the spectrum to the given time and runs the inverse FFT
+    void update(float time)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, spectrumSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, heightSSBO);
+
+        evolveShader.use();
+        evolveShader.setUInt("fftSize", FFT_SIZE);
+        evolveShader.setFloat("patchSize", params.patchSize);
+        evolveShader.setFloat("time", time);
+        glDispatchCompute(FFT_SIZE / 16, FFT_SIZE / 16, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // rows, then columns - one work group per line
+        fftShader.use();
+        fftShader.setUInt("direction", 0);
+        glDispatchCompute(FFT_SIZE, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        fftShader.setUInt("direction", 1);
+        glDispatchCompute(FFT_SIZE, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // binds the height field for a water kernel that includes wave.glsl
+    void bindHeightField(Shader& shader)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, heightSSBO);
+        shader.setUInt("waveModel", 1);
+        shader.setUInt("fftSize", FFT_SIZE);
+        shader.setFloat("patchSize", params.patchSize);
+    }
+
+    // Conservative bound of |height| for culling. Heights are a sum of many
+    // random components, so they are close to normal with variance sum |h0|^2;
+    // six standard deviations is never exceeded in practice.
+    float maxHeight() const
+    {
+        OceanSpectrum spectrum(params);
+        double variance = 0.0;
+        for (size_t i = 0; i < spectrum.h0.size(); i++)
+            variance += std::norm(spectrum.h0[i]) + std::norm(spectrum.h0MinusConj[i]);
+        return 6.0f * (float)std::sqrt(variance);
+    }
+
+    // Copies the current heights into a readback buffer behind a fence, call after update().
+    // Does nothing while the previous copy hasn't been collected by readHeights().
+    void requestHeights()
+    {
+        if (readbackFence != 0)
+            return;
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT); // the FFT wrote the heights as an SSBO
+        glBindBuffer(GL_COPY_READ_BUFFER, heightSSBO);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, FFT_SIZE * FFT_SIZE * sizeof(glm::vec2));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // Collects the copy made by requestHeights() as a sign-corrected FFT_SIZE x FFT_SIZE
+    // height map (same layout as OceanSpectrum::heights). Without wait it returns
+    // false instead of stalling when the GPU hasn't got there yet.
+    bool readHeights(std::vector<float>& heights, bool wait = false)
+    {
+        if (readbackFence == 0)
+            return false;
+        GLenum status = glClientWaitSync(readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(readbackFence);
+        readbackFence = 0;
+
+        std::vector<glm::vec2> hkt(FFT_SIZE * FFT_SIZE);
+        glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffer);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, hkt.size() * sizeof(glm::vec2), hkt.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        // the spectrum is centred on k = 0, which flips the sign of every other texel
+        heights.resize(hkt.size());
+        for (unsigned int m = 0; m < FFT_SIZE; m++)
+            for (unsigned int n = 0; n < FFT_SIZE; n++)
+                heights[m * FFT_SIZE + n] = hkt[m * FFT_SIZE + n].x * (((n + m) & 1) ? -1.0f : 1.0f);
+        return true;
+    }
+
+    GLuint getHeightBuffer() const
+    {
+        return heightSSBO;
+    }
+
+private:
+    Shader spectrumShader;
+    Shader evolveShader;
+    Shader fftShader;
+
+    GLuint spectrumSSBO, heightSSBO;
+    GLuint readbackBuffer;
+    GLsync readbackFence;
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef OCEAN_SPECTRUM_H
+#define OCEAN_SPECTRUM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "Random.h"
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+// Parameters of the Tessendorf ocean, shared by the GPU pipeline (OceanFFT)
+// and the CPU reference implementation below
+struct OceanParams {
+    unsigned int size = 256;        // FFT resolution, power of two (the GPU kernels are compiled for 256)
+    float patchSize = 256.0f;       // world-space width of one periodic ocean tile
+    float windSpeed = 5.0f;
+    glm::vec2 windDir = glm::vec2(-0.70710678f, -0.70710678f);
+    float amplitude = 5e-6f;        // Phillips spectrum constant, gives ~0.3 rms height at 5 m/s wind
+    unsigned int seed = 1337;
+};
+
+// CPU reference of the FFT ocean. Every step mirrors one of the compute shaders
+// in resources/shaders/water/ocean_*.cs.glsl and wave.glsl (same hash, same butterfly order)
+// so GPU output can be checked against it.
+class OceanSpectrum
+{
+public:
+    typedef std::complex<float> complex;
+
+    OceanParams params;
+    std::vector<complex> h0;          // h0(k)
+    std::vector<complex> h0MinusConj; // conj(h0(-k))
+
+    OceanSpectrum(const OceanParams& params)
+    {
+        this->params = params;
+        initSpectrum();
+    }
+
+    // ocean_spectrum.cs.glsl
+    void initSpectrum()
+    {
+        unsigned int N = params.size;
+        h0.assign(N * N, complex(0.0f));
+        h0MinusConj.assign(N * N, complex(0.0f));
+
+        for (unsigned int m = 0; m < N; m++) {
+            for (unsigned int n = 0; n < N; n++) {
+                glm::vec2 k = waveVector(n, m);
+                unsigned int nMinus = (N - n) % N;
+                unsigned int mMinus = (N - m) % N;
+
+                glm::vec2 xi = gaussianPair(m * N + n);
+                glm::vec2 xiMinus = gaussianPair(mMinus * N + nMinus);
+
+                float p = std::sqrt(phillips(k) * 0.5f);
+                float pMinus = std::sqrt(phillips(-k) * 0.5f);
+
+                h0[m * N + n] = complex(xi.x * p, xi.y * p);
+                h0MinusConj[m * N + n] = complex(xiMinus.x * pMinus, -xiMinus.y * pMinus);
+            }
+        }
+    }
+
+    // ocean_evolve.cs.glsl - h(k, t) = h0(k) e^(iwt) + conj(h0(-k)) e^(-iwt)
+    void evolve(float time, std::vector<complex>& hkt) const
+    {
+        unsigned int N = params.size;
+        hkt.resize(N * N);
+        for (unsigned int m = 0; m < N; m++) {
+            for (unsigned int n = 0; n < N; n++) {
+                float omega = dispersion(waveVector(n, m));
+                complex e(std::cos(omega * time), std::sin(omega * time));
+                unsigned int i = m * N + n;
+                hkt[i] = h0[i] * e + h0MinusConj[i] * std::conj(e);
+            }
+        }
+    }
+
+    // ocean_fft.cs.glsl - in-place 2D inverse FFT, rows then columns
+    static void inverseFFT2D(std::vector<complex>& data, unsigned int N)
+    {
+        std::vector<complex> line(N);
+        for (unsigned int pass = 0; pass < 2; pass++) {
+            for (unsigned int l = 0; l < N; l++) {
+                for (unsigned int j = 0; j < N; j++)
+                    line[j] = data[pass == 0 ? l * N + j : j * N + l];
+                inverseFFT(line);
+                for (unsigned int j = 0; j < N; j++)
+                    data[pass == 0 ? l * N + j : j * N + l] = line[j];
+            }
+        }
+    }
+
+    // radix-2 decimation in time, same butterfly order as the compute shader
+    static void inverseFFT(std::vector<complex>& line)
+    {
+        unsigned int N = (unsigned int)line.size();
+        unsigned int bits = 0;
+        while ((1u << bits) < N) bits++;
+
+        std::vector<complex> tmp(N);
+        for (unsigned int j = 0; j < N; j++)
+            tmp[reverseBits(j, bits)] = line[j];
+
+        for (unsigned int span = 1; span < N; span <<= 1) {
+            for (unsigned int t = 0; t < N / 2; t++) {
+                unsigned int pos = t & (span - 1);
+                unsigned int a = ((t - pos) << 1) + pos;
+                unsigned int b = a + span;
+                float angle = glm::pi<float>() * (float)pos / (float)span;
+                complex u = tmp[a];
+                complex v = tmp[b] * complex(std::cos(angle), std::sin(angle));
+                tmp[a] = u + v;
+                tmp[b] = u - v;
+            }
+        }
+        line = tmp;
+    }
+
+    // full pipeline for one time step, returns the N*N height map (sign already corrected)
+    std::vector<float> heights(float time) const
+    {
+        unsigned int N = params.size;
+        std::vector<complex> hkt;
+        evolve(time, hkt);
+        inverseFFT2D(hkt, N);
+
+        std::vector<float> result(N * N);
+        for (unsigned int m = 0; m < N; m++)
+            for (unsigned int n = 0; n < N; n++)
+                result[m * N + n] = hkt[m * N + n].real() * (((n + m) & 1) ? -1.0f : 1.0f);
+        return result;
+    }
+
+    // fftWaveHeight in wave.glsl - bilinear lookup of the periodic height map at world (x, z)
+    float sample(const std::vector<float>& heightMap, float x, float z) const
+    {
+        int N = (int)params.size;
+        float u = x / params.patchSize * N;
+        float v = z / params.patchSize * N;
+        int x0 = (int)std::floor(u);
+        int z0 = (int)std::floor(v);
+        float fx = u - x0;
+        float fz = v - z0;
+
+        float h00 = heightMap[(z0 & (N - 1)) * N + (x0 & (N - 1))];
+        float h10 = heightMap[(z0 & (N - 1)) * N + ((x0 + 1) & (N - 1))];
+        float h01 = heightMap[((z0 + 1) & (N - 1)) * N + (x0 & (N - 1))];
+        float h11 = heightMap[((z0 + 1) & (N - 1)) * N + ((x0 + 1) & (N - 1))];
+        return glm::mix(glm::mix(h00, h10, fx), glm::mix(h01, h11, fx), fz);
+    }
+
+    glm::vec2 waveVector(unsigned int n, unsigned int m) const
+    {
+        float N = (float)params.size;
+        return glm::vec2((float)n - N / 2.0f, (float)m - N / 2.0f) * (2.0f * glm::pi<float>() / params.patchSize);
+    }
+
+    float phillips(glm::vec2 k) const
+    {
+        const float g = 9.81f;
+        float k2 = glm::dot(k, k);
+        if (k2 < 1e-8f)
+            return 0.0f;
+
+        float L = params.windSpeed * params.windSpeed / g; // largest wave arising from the wind
+        float kdw = glm::dot(k / std::sqrt(k2), params.windDir);
+        float p = params.amplitude * std::exp(-1.0f / (k2 * L * L)) / (k2 * k2) * kdw * kdw;
+        if (kdw < 0.0f)
+            p *= 0.07f; // waves moving against the wind are mostly suppressed
+
+        float l = L * 0.001f; // suppress very small waves
+        return p * std::exp(-k2 * l * l);
+    }
+
+    static float dispersion(glm::vec2 k)
+    {
+        return std::sqrt(9.81f * glm::length(k));
+    }
+
+    // two independent N(0, 1) samples for a spectrum index (Box-Muller)
+    glm::vec2 gaussianPair(uint32_t index) const
+    {
+        uint32_t s = pcgHash(params.seed);
+        // 24-bit uniforms are exact in float on both CPU and GPU
+        float u1 = ((float)(pcgHash(2u * index + s) >> 8) + 1.0f) / 16777216.0f;
+        float u2 = (float)(pcgHash(2u * index + 1u + s) >> 8) / 16777216.0f;
+        float r = std::sqrt(-2.0f * std::log(u1));
+        float theta = 2.0f * glm::pi<float>() * u2;
+        return glm::vec2(r * std::cos(theta), r * std::sin(theta));
+    }
+
+private:
+    static unsigned int reverseBits(unsigned int v, unsigned int bits)
+    {
+        unsigned int r = 0;
+        for (unsigned int i = 0; i < bits; i++) {
+            r = (r << 1) | (v & 1);
+            v >>= 1;
+        }
+        return r;
+    }
+};
+
+#endif
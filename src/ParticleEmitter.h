@@ -0,0 +1,113 @@
+#ifndef PARTICLE_EMITTER_H
+#define PARTICLE_EMITTER_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "ParticleSystem.h"
+#include "Random.h"
+
+#include <cmath>
+#include <iostream>
+
+// Emits wind particles at a rate in particles per second, independent of the
+// frame rate. update() turns the frame time into a whole number of particles
+// (the fraction carries over to the next frame), spawn() creates that batch in
+// one pass over the ParticleSystem arrays.
+//
+// The rate falls off when the emitter is far from the camera, with the square
+// of the distance like the screen area the particles cover, and one frame never
+// spawns more than frameBudget particles; the excess of the rate is dropped
+// rather than carried over, so a long frame can't cause a spike of spawns.
+class ParticleEmitter
+{
+public:
+    // the spawn volume, must match particle_emit.cs.glsl
+    static constexpr float MIN_DISTANCE_AGAINST_WIND = 8.0f;
+    static constexpr float MAX_DISTANCE_AGAINST_WIND = 22.0f;
+    static constexpr float TUNNEL_WIDTH = 14.0f;
+    static constexpr float MIN_HEIGHT = 0.2f;
+    static constexpr float MAX_HEIGHT = 4.2f;
+
+    float rate;                // particles per second at full density
+    unsigned int frameBudget;  // most particles spawned in one frame
+    float fullDensityDistance; // camera distance up to which the full rate is emitted
+
+    ParticleEmitter(float rate, unsigned int frameBudget, float fullDensityDistance = 30.0f)
+    {
+        this->rate = rate;
+        this->frameBudget = frameBudget;
+        this->fullDensityDistance = fullDensityDistance;
+    }
+
+    // number of particles due this frame
+    unsigned int update(float deltaTime, float cameraDistance)
+    {
+        density = 1.0f;
+        if (cameraDistance > fullDensityDistance)
+            density = (fullDensityDistance * fullDensityDistance) / (cameraDistance * cameraDistance);
+
+        carry += rate * density * deltaTime;
+        unsigned int count = (unsigned int)carry;
+        carry -= count;
+
+        if (count > frameBudget) {
+            overBudget += count - frameBudget;
+            count = frameBudget;
+        }
+        return count;
+    }
+
+    // Spawns count particles in the cylindrical volume against the wind from
+    // emitterPos. Spawn n draws from RandomStream(params.spawnSeed, n), the same
+    // stream particle_emit.cs.glsl uses, so both produce the same particles.
+    // Every particle depends only on its spawn number, the loop carries nothing.
+    void spawn(ParticleSystem& particles, unsigned int count, const glm::vec3& emitterPos, const WindParticleParams& params)
+    {
+        unsigned int first;
+        unsigned int granted = particles.allocate(count, first);
+
+        glm::vec3 wind = glm::normalize(params.windDirection);
+        glm::vec3 side = glm::normalize(glm::cross(wind, glm::vec3(0.0f, 1.0f, 0.0f)));
+        for (unsigned int i = 0; i < granted; i++) {
+            RandomStream random(params.spawnSeed, spawned + i);
+            float shade = random.nextRange(0.8f, 0.9f);
+            float height = random.nextRange(MIN_HEIGHT, MAX_HEIGHT);
+            float distanceAgainstWind = random.nextRange(MIN_DISTANCE_AGAINST_WIND, MAX_DISTANCE_AGAINST_WIND);
+            float distanceToSide = random.nextRange(-TUNNEL_WIDTH / 2.0f, TUNNEL_WIDTH / 2.0f);
+            float seed = random.nextRange(-glm::pi<float>(), glm::pi<float>());
+
+            // distanceToSide is signed, the particles fill the tunnel on both sides of the emitter
+            glm::vec3 offset = -wind * distanceAgainstWind + side * distanceToSide;
+            unsigned int p = first + i;
+            particles.px[p] = emitterPos.x + offset.x;
+            particles.py[p] = emitterPos.y + height;
+            particles.pz[p] = emitterPos.z + offset.z;
+            particles.shade[p] = shade;
+            particles.seed[p] = seed;
+            particles.life[p] = params.life;
+            particles.alpha[p] = 0.0f; // fades in
+        }
+        // dropped spawns still use up their numbers, like on the GPU
+        spawned += count;
+    }
+
+    // prints the density and the spawns over budget once per interval
+    void reportStats(double now, double interval = 2.0)
+    {
+        if (now - lastReport < interval)
+            return;
+        lastReport = now;
+        std::cout << "wind emitter: " << rate * density << " particles/s (density " << density << "), "
+                  << overBudget << " over the frame budget of " << frameBudget << std::endl;
+    }
+
+private:
+    float carry = 0.0f;      // fraction of a particle left over from the last frame
+    unsigned int spawned = 0; // spawns so far, the random stream of the next one
+    float density = 1.0f;
+    unsigned int overBudget = 0;
+    double lastReport = 0.0;
+};
+
+#endif
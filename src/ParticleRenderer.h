@@ -0,0 +1,95 @@
+#ifndef PARTICLE_RENDERER_H
+#define PARTICLE_RENDERER_H
+
+#include <GLAD/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Per-instance data of v_wind_particle.glsl, std430 layout
+struct ParticleInstance {
+    glm::vec3 position;
+    float scale;
+    glm::vec4 color;    // rgb, a - alpha
+    glm::vec3 velocity; // for velocity streaks
+    float unused;
+};
+
+// Draws CPU-side particles with one instanced draw call. The instances are
+// streamed into a shader storage buffer every frame (the old storage is
+// orphaned, so the upload never waits for the previous frame's draw). There is
+// no vertex buffer: the vertex shader reads its instance by gl_InstanceID and
+// builds a camera-facing quad from gl_VertexID, see billboard.glsl.
+//
+// SSBO binding 9 - instances
+class ParticleRenderer
+{
+public:
+    ParticleRenderer(unsigned int initialCapacity = 1024)
+    {
+        capacity = initialCapacity;
+
+        // the core profile needs a VAO bound to draw, even one without attributes
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &instanceSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(ParticleInstance), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    ~ParticleRenderer()
+    {
+        glDeleteBuffers(1, &instanceSSBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // shader is v_wind_particle.glsl + f_wind_particle.glsl, already in use
+    void draw(const std::vector<ParticleInstance>& instances)
+    {
+        frames++;
+        instancesDrawn += instances.size();
+        if (instances.empty())
+            return;
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceSSBO);
+        if (instances.size() > capacity) {
+            while (capacity < instances.size())
+                capacity *= 2;
+        }
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(ParticleInstance), nullptr, GL_STREAM_DRAW); // orphan
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, instances.size() * sizeof(ParticleInstance), instances.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, instanceSSBO);
+
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)instances.size());
+        glBindVertexArray(0);
+        drawCalls++;
+    }
+
+    // Prints the draw calls per frame once per interval, next to the one call
+    // per particle the draw loop used to issue.
+    void reportStats(double now, double interval = 2.0)
+    {
+        if (now - lastReport < interval || frames == 0)
+            return;
+        lastReport = now;
+
+        std::cout << "wind particles: " << (double)drawCalls / frames << " draw calls per frame for "
+                  << (double)instancesDrawn / frames << " particles (one call per particle before instancing)" << std::endl;
+        frames = 0;
+        drawCalls = 0;
+        instancesDrawn = 0;
+    }
+
+private:
+    GLuint VAO, instanceSSBO;
+    size_t capacity;
+
+    double lastReport = 0.0;
+    unsigned long long frames = 0, drawCalls = 0, instancesDrawn = 0;
+};
+
+#endif
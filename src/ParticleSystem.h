@@ -0,0 +1,325 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <glm/glm.hpp>
+
+#include "SimdMath.h"
+#include "CpuFeatures.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Wind settings shared by the CPU and GPU particle updates
+struct WindParticleParams {
+    glm::vec3 windDirection = glm::vec3(-0.70710678f, 0.0f, -0.70710678f);
+    float windSpeed = 5.0f;
+    float windWaveFrequency = 1.0f;
+    float sideAmplitude = 0.4f;
+    float life = 9.0f;
+    float scale = 0.3f;
+    unsigned int spawnSeed = 1; // spawn n draws from RandomStream(spawnSeed, n) on the CPU and the GPU
+};
+
+enum class ParticleKernel {
+    Scalar,
+    SSE,  // 4 particles per iteration
+    AVX2  // 8 particles per iteration, AVX2 + FMA
+};
+
+// CPU wind particles in structure-of-arrays layout. The update touches only
+// positions, life, alpha and seed, each in its own 32-byte aligned array, so
+// every loaded cache line is fully used and the kernels can load 4 or 8
+// particles with one instruction. The arrays are padded to a multiple of 8
+// with dead particles, so the SIMD kernels need no scalar tail.
+//
+// The live particles are kept packed in [0, aliveCount()): spawn() appends at
+// the end and a particle that dies is replaced by the last live one. The slots
+// after the live range are the free list, so spawning is O(1) and the update
+// and rendering only ever walk live particles.
+//
+// The kernel is picked from the CPU features at runtime, all three compute
+// the same thing (the SIMD sine differs from std::sin by ~1e-7).
+class ParticleSystem
+{
+public:
+    typedef std::vector<float, AlignedAllocator<float, 32>> FloatArray;
+
+    // particles per step of the widest kernel, the arrays are padded to it
+    static constexpr unsigned int SIMD_GROUP = 8;
+
+    FloatArray px, py, pz;
+    FloatArray life;  // <= 0 when dead
+    FloatArray alpha;
+    FloatArray seed;  // phase of the side sway
+    FloatArray shade; // grey level of the color
+
+    ParticleKernel kernel;
+
+    ParticleSystem(unsigned int capacity)
+    {
+        this->capacity = capacity;
+        unsigned int padded = (capacity + SIMD_GROUP - 1) & ~(SIMD_GROUP - 1);
+        for (FloatArray* a : { &px, &py, &pz, &life, &alpha, &seed, &shade })
+            a->assign(padded, 0.0f);
+        kernel = bestKernel();
+        alive = 0;
+        droppedSpawns = 0;
+    }
+
+    unsigned int size() const
+    {
+        return capacity;
+    }
+
+    // particles 0 .. aliveCount() - 1 are alive
+    unsigned int aliveCount() const
+    {
+        return alive;
+    }
+
+    glm::vec3 position(unsigned int i) const
+    {
+        return glm::vec3(px[i], py[i], pz[i]);
+    }
+
+    // Appends up to count particles after the live ones and returns how many fit,
+    // the rest are dropped. The caller fills [first, first + result) like spawn().
+    unsigned int allocate(unsigned int count, unsigned int& first)
+    {
+        unsigned int granted = count < capacity - alive ? count : capacity - alive;
+        droppedSpawns += count - granted;
+        first = alive;
+        alive += granted;
+        return granted;
+    }
+
+    // the velocity the update gives particle i at time, for drawing
+    glm::vec3 velocity(unsigned int i, const WindParticleParams& params, float time) const
+    {
+        glm::vec3 sideAxis = glm::normalize(glm::cross(params.windDirection, glm::vec3(0.0f, 1.0f, 0.0f)));
+        float sideOffset = std::sin((time + seed[i]) * params.windWaveFrequency) * params.sideAmplitude;
+        return glm::normalize(params.windDirection + sideAxis * sideOffset) * params.windSpeed;
+    }
+
+    // false when the pool is full, live particles are never overwritten
+    bool spawn(const glm::vec3& position, float shade, float seed, float life)
+    {
+        unsigned int i;
+        if (allocate(1, i) == 0)
+            return false;
+        px[i] = position.x;
+        py[i] = position.y;
+        pz[i] = position.z;
+        this->shade[i] = shade;
+        this->seed[i] = seed;
+        this->life[i] = life;
+        alpha[i] = 0.0f; // fades in
+        return true;
+    }
+
+    // ages, moves and fades the live particles, then removes the ones that died
+    void update(const WindParticleParams& params, float deltaTime, float time)
+    {
+        simulate(params, deltaTime, time, 0, alive);
+        compact();
+    }
+
+    // the update of particles [begin, end) without the removal, so ranges can run
+    // on different threads; begin must be a multiple of 8 (SIMD_GROUP)
+    void simulate(const WindParticleParams& params, float deltaTime, float time, unsigned int begin, unsigned int end)
+    {
+        // whole SIMD groups, the slots past the live range are dead
+        end = (end + SIMD_GROUP - 1) & ~(SIMD_GROUP - 1);
+        switch (kernel) {
+#ifdef SIMD_AVX2
+        case ParticleKernel::AVX2:
+            updateAVX2(params, deltaTime, time, begin, end);
+            break;
+#endif
+#ifdef SIMD_SSE2
+        case ParticleKernel::SSE:
+            updateSSE(params, deltaTime, time, begin, end);
+            break;
+#endif
+        default:
+            updateScalar(params, deltaTime, time, begin, end);
+            break;
+        }
+    }
+
+    // swap-remove of every particle that died in simulate()
+    void compact()
+    {
+        unsigned int i = 0;
+        while (i < alive) {
+            if (life[i] > 0.0f) {
+                i++;
+                continue;
+            }
+            unsigned int last = --alive;
+            px[i] = px[last];
+            py[i] = py[last];
+            pz[i] = pz[last];
+            life[i] = life[last];
+            alpha[i] = alpha[last];
+            seed[i] = seed[last];
+            shade[i] = shade[last];
+            life[last] = 0.0f; // the kernels may still load it as part of a SIMD group
+        }
+    }
+
+    // prints the live count and the spawns lost to a full pool once per interval
+    void reportStats(double now, double interval = 2.0)
+    {
+        if (now - lastReport < interval)
+            return;
+        lastReport = now;
+        std::cout << "wind particles (CPU, " << kernelName(kernel) << "): " << alive << " / " << capacity << " alive, "
+                  << droppedSpawns << " spawns dropped" << std::endl;
+    }
+
+    static ParticleKernel bestKernel()
+    {
+        const CpuFeatures& cpu = CpuFeatures::get();
+#ifdef SIMD_AVX2
+        if (cpu.avx2 && cpu.fma)
+            return ParticleKernel::AVX2;
+#endif
+#ifdef SIMD_SSE2
+        if (cpu.sse2)
+            return ParticleKernel::SSE;
+#endif
+        return ParticleKernel::Scalar;
+    }
+
+    static const char* kernelName(ParticleKernel kernel)
+    {
+        const char* names[] = { "scalar", "SSE", "AVX2" };
+        return names[(int)kernel];
+    }
+
+private:
+    unsigned int capacity;
+    unsigned int alive;
+    unsigned int droppedSpawns;
+    double lastReport = 0.0;
+
+    void updateScalar(const WindParticleParams& params, float deltaTime, float time, unsigned int begin, unsigned int end)
+    {
+        glm::vec3 wind = params.windDirection;
+        glm::vec3 sideAxis = glm::normalize(glm::cross(wind, glm::vec3(0.0f, 1.0f, 0.0f)));
+        float fade = deltaTime * 2.5f;
+
+        for (unsigned int i = begin; i < end; i++) {
+            life[i] -= deltaTime;
+            if (life[i] <= 0.0f)
+                continue;
+
+            float sideOffset = std::sin((time + seed[i]) * params.windWaveFrequency) * params.sideAmplitude;
+            glm::vec3 velocity = wind + sideAxis * sideOffset;
+            float step = params.windSpeed * deltaTime / std::sqrt(glm::dot(velocity, velocity));
+            px[i] += velocity.x * step;
+            py[i] += velocity.y * step;
+            pz[i] += velocity.z * step;
+
+            if (life[i] < 1.0f)
+                alpha[i] -= fade;
+            else if (life[i] > params.life - 1.0f && alpha[i] < 1.0f - fade)
+                alpha[i] += fade;
+        }
+    }
+
+#ifdef SIMD_SSE2
+    void updateSSE(const WindParticleParams& params, float deltaTime, float time, unsigned int begin, unsigned int end)
+    {
+        glm::vec3 wind = params.windDirection;
+        glm::vec3 side = glm::normalize(glm::cross(wind, glm::vec3(0.0f, 1.0f, 0.0f)));
+        __m128 windX = _mm_set1_ps(wind.x), windY = _mm_set1_ps(wind.y), windZ = _mm_set1_ps(wind.z);
+        __m128 sideX = _mm_set1_ps(side.x), sideY = _mm_set1_ps(side.y), sideZ = _mm_set1_ps(side.z);
+        __m128 dt = _mm_set1_ps(deltaTime);
+        __m128 t = _mm_set1_ps(time);
+        __m128 frequency = _mm_set1_ps(params.windWaveFrequency);
+        __m128 amplitude = _mm_set1_ps(params.sideAmplitude);
+        __m128 distance = _mm_set1_ps(params.windSpeed * deltaTime);
+        __m128 fade = _mm_set1_ps(deltaTime * 2.5f);
+        __m128 zero = _mm_setzero_ps();
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 fadeInAfter = _mm_set1_ps(params.life - 1.0f);
+        __m128 fadeInBelow = _mm_set1_ps(1.0f - deltaTime * 2.5f);
+
+        for (unsigned int i = begin; i < end; i += 4) {
+            __m128 l = _mm_sub_ps(_mm_load_ps(&life[i]), dt);
+            _mm_store_ps(&life[i], l);
+            __m128 alive = _mm_cmpgt_ps(l, zero);
+            if (_mm_movemask_ps(alive) == 0)
+                continue;
+
+            __m128 sideOffset = _mm_mul_ps(simdSin4(_mm_mul_ps(_mm_add_ps(t, _mm_load_ps(&seed[i])), frequency)), amplitude);
+            __m128 vx = _mm_add_ps(windX, _mm_mul_ps(sideX, sideOffset));
+            __m128 vy = _mm_add_ps(windY, _mm_mul_ps(sideY, sideOffset));
+            __m128 vz = _mm_add_ps(windZ, _mm_mul_ps(sideZ, sideOffset));
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+            __m128 step = _mm_and_ps(alive, _mm_div_ps(distance, length));
+            _mm_store_ps(&px[i], _mm_add_ps(_mm_load_ps(&px[i]), _mm_mul_ps(vx, step)));
+            _mm_store_ps(&py[i], _mm_add_ps(_mm_load_ps(&py[i]), _mm_mul_ps(vy, step)));
+            _mm_store_ps(&pz[i], _mm_add_ps(_mm_load_ps(&pz[i]), _mm_mul_ps(vz, step)));
+
+            __m128 a = _mm_load_ps(&alpha[i]);
+            __m128 fadeOut = _mm_and_ps(alive, _mm_cmplt_ps(l, one));
+            __m128 fadeIn = _mm_andnot_ps(fadeOut, _mm_and_ps(alive, _mm_and_ps(_mm_cmpgt_ps(l, fadeInAfter), _mm_cmplt_ps(a, fadeInBelow))));
+            a = _mm_sub_ps(a, _mm_and_ps(fadeOut, fade));
+            a = _mm_add_ps(a, _mm_and_ps(fadeIn, fade));
+            _mm_store_ps(&alpha[i], a);
+        }
+    }
+#endif
+
+#ifdef SIMD_AVX2
+    SIMD_TARGET_AVX2 void updateAVX2(const WindParticleParams& params, float deltaTime, float time, unsigned int begin, unsigned int end)
+    {
+        glm::vec3 wind = params.windDirection;
+        glm::vec3 side = glm::normalize(glm::cross(wind, glm::vec3(0.0f, 1.0f, 0.0f)));
+        __m256 windX = _mm256_set1_ps(wind.x), windY = _mm256_set1_ps(wind.y), windZ = _mm256_set1_ps(wind.z);
+        __m256 sideX = _mm256_set1_ps(side.x), sideY = _mm256_set1_ps(side.y), sideZ = _mm256_set1_ps(side.z);
+        __m256 dt = _mm256_set1_ps(deltaTime);
+        __m256 t = _mm256_set1_ps(time);
+        __m256 frequency = _mm256_set1_ps(params.windWaveFrequency);
+        __m256 amplitude = _mm256_set1_ps(params.sideAmplitude);
+        __m256 distance = _mm256_set1_ps(params.windSpeed * deltaTime);
+        __m256 fade = _mm256_set1_ps(deltaTime * 2.5f);
+        __m256 zero = _mm256_setzero_ps();
+        __m256 one = _mm256_set1_ps(1.0f);
+        __m256 fadeInAfter = _mm256_set1_ps(params.life - 1.0f);
+        __m256 fadeInBelow = _mm256_set1_ps(1.0f - deltaTime * 2.5f);
+
+        for (unsigned int i = begin; i < end; i += 8) {
+            __m256 l = _mm256_sub_ps(_mm256_load_ps(&life[i]), dt);
+            _mm256_store_ps(&life[i], l);
+            __m256 alive = _mm256_cmp_ps(l, zero, _CMP_GT_OQ);
+            if (_mm256_movemask_ps(alive) == 0)
+                continue;
+
+            __m256 sideOffset = _mm256_mul_ps(simdSin8(_mm256_mul_ps(_mm256_add_ps(t, _mm256_load_ps(&seed[i])), frequency)), amplitude);
+            __m256 vx = _mm256_fmadd_ps(sideX, sideOffset, windX);
+            __m256 vy = _mm256_fmadd_ps(sideY, sideOffset, windY);
+            __m256 vz = _mm256_fmadd_ps(sideZ, sideOffset, windZ);
+            __m256 length = _mm256_sqrt_ps(_mm256_fmadd_ps(vx, vx, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vz, vz))));
+            __m256 step = _mm256_and_ps(alive, _mm256_div_ps(distance, length));
+            _mm256_store_ps(&px[i], _mm256_fmadd_ps(vx, step, _mm256_load_ps(&px[i])));
+            _mm256_store_ps(&py[i], _mm256_fmadd_ps(vy, step, _mm256_load_ps(&py[i])));
+            _mm256_store_ps(&pz[i], _mm256_fmadd_ps(vz, step, _mm256_load_ps(&pz[i])));
+
+            __m256 a = _mm256_load_ps(&alpha[i]);
+            __m256 fadeOut = _mm256_and_ps(alive, _mm256_cmp_ps(l, one, _CMP_LT_OQ));
+            __m256 fadeIn = _mm256_andnot_ps(fadeOut, _mm256_and_ps(alive,
+                _mm256_and_ps(_mm256_cmp_ps(l, fadeInAfter, _CMP_GT_OQ), _mm256_cmp_ps(a, fadeInBelow, _CMP_LT_OQ))));
+            a = _mm256_sub_ps(a, _mm256_and_ps(fadeOut, fade));
+            a = _mm256_add_ps(a, _mm256_and_ps(fadeIn, fade));
+            _mm256_store_ps(&alpha[i], a);
+        }
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Counter-based random numbers, the CPU side of resources/shaders/random.glsl.
+//
+// Draw n of stream s under seed is pcgHash(key(seed, s) + n): there is no
+// state besides the counter, so any draw can be computed directly, streams
+// never share state between threads, and the GPU kernels reproduce the exact
+// CPU sequence from the same seed, stream and counter. Give every thread or
+// job its own stream (a thread index, a particle index, ...) and the results
+// do not depend on scheduling.
+//
+// Uniform floats have 24 bits, which float represents exactly on both sides.
+
+// pcg hash, identical to pcgHash in random.glsl
+inline uint32_t pcgHash(uint32_t v)
+{
+    uint32_t state = v * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+class RandomStream
+{
+public:
+    uint32_t key;
+    uint32_t counter; // index of the next draw
+
+    RandomStream(uint32_t seed = 0, uint32_t stream = 0)
+    {
+        key = pcgHash(seed ^ pcgHash(stream));
+        counter = 0;
+    }
+
+    uint32_t nextUInt()
+    {
+        return pcgHash(key + counter++);
+    }
+
+    // [0, 1)
+    float nextFloat()
+    {
+        return toFloat(nextUInt());
+    }
+
+    // [lo, hi)
+    float nextRange(float lo, float hi)
+    {
+        return lo + (hi - lo) * nextFloat();
+    }
+
+    // N(0, 1), uses two draws
+    float nextNormal()
+    {
+        float u1 = toOpenFloat(nextUInt());
+        float u2 = nextFloat();
+        return std::sqrt(-2.0f * std::log(u1)) * std::cos(TWO_PI * u2);
+    }
+
+    // count uniforms in [lo, hi). The draws are independent of each other, so the
+    // loop has no carried dependency and vectorises.
+    void fillUniform(float* out, size_t count, float lo = 0.0f, float hi = 1.0f)
+    {
+        uint32_t base = counter;
+        for (size_t i = 0; i < count; i++)
+            out[i] = lo + (hi - lo) * toFloat(pcgHash(key + base + (uint32_t)i));
+        counter += (uint32_t)count;
+    }
+
+    // count N(mean, sigma^2) samples, Box-Muller gives two per pair of draws
+    void fillNormal(float* out, size_t count, float mean = 0.0f, float sigma = 1.0f)
+    {
+        uint32_t base = counter;
+        size_t pairs = (count + 1) / 2;
+        for (size_t i = 0; i < pairs; i++) {
+            float u1 = toOpenFloat(pcgHash(key + base + 2 * (uint32_t)i));
+            float u2 = toFloat(pcgHash(key + base + 2 * (uint32_t)i + 1));
+            float r = std::sqrt(-2.0f * std::log(u1)) * sigma;
+            out[2 * i] = mean + r * std::cos(TWO_PI * u2);
+            if (2 * i + 1 < count)
+                out[2 * i + 1] = mean + r * std::sin(TWO_PI * u2);
+        }
+        counter += 2 * (uint32_t)pairs;
+    }
+
+    // top 24 bits as [0, 1)
+    static float toFloat(uint32_t bits)
+    {
+        return (float)(bits >> 8) / 16777216.0f;
+    }
+
+    // (0, 1], for logarithms
+    static float toOpenFloat(uint32_t bits)
+    {
+        return ((float)(bits >> 8) + 1.0f) / 16777216.0f;
+    }
+
+private:
+    static constexpr float TWO_PI = 6.28318530718f;
+};
+
+#endif
@@ -19,10 +19,19 @@ public:
 
     // constructor reads and builds the shader
     Shader(const char* computePath, const char* vertexPath, const char* geometryPath, const char* fragmentPath)
+        : Shader(computePath, vertexPath, NULL, NULL, geometryPath, fragmentPath)
+    {
+    }
+
+    // same as above, with tessellation control and evaluation stages
+    Shader(const char* computePath, const char* vertexPath, const char* tessControlPath, const char* tessEvaluationPath,
+           const char* geometryPath, const char* fragmentPath)
     {
         // 1. retrieve the shader source code from filePath
         std::string computeCode;
         std::string vertexCode;
+        std::string tessControlCode;
+        std::string tessEvaluationCode;
         std::string geometryCode;
         std::string fragmentCode;
 
@@ -35,7 +44,7 @@ public:
                 std::stringstream cShaderStream;
                 cShaderStream << cShaderFile.rdbuf();
                 cShaderFile.close();
-                computeCode = cShaderStream.str();
+                computeCode = resolveIncludes(cShaderStream.str(), computePath);
             }
             catch (std::ifstream::failure e) {
                 std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: COMPUTE" << std::endl;
@@ -51,13 +60,45 @@ public:
                 std::stringstream vShaderStream;
                 vShaderStream << vShaderFile.rdbuf();
                 vShaderFile.close();
-                vertexCode = vShaderStream.str();
+                vertexCode = resolveIncludes(vShaderStream.str(), vertexPath);
             }
             catch (std::ifstream::failure e) {
                 std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: VERTEX" << std::endl;
             }
         }
 
+        // Tessellation Control Shader
+        if (tessControlPath != nullptr) {
+            std::ifstream tcShaderFile;
+            tcShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+            try {
+                tcShaderFile.open(tessControlPath);
+                std::stringstream tcShaderStream;
+                tcShaderStream << tcShaderFile.rdbuf();
+                tcShaderFile.close();
+                tessControlCode = resolveIncludes(tcShaderStream.str(), tessControlPath);
+            }
+            catch (std::ifstream::failure e) {
+                std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: TESS_CONTROL" << std::endl;
+            }
+        }
+
+        // Tessellation Evaluation Shader
+        if (tessEvaluationPath != nullptr) {
+            std::ifstream teShaderFile;
+            teShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+            try {
+                teShaderFile.open(tessEvaluationPath);
+                std::stringstream teShaderStream;
+                teShaderStream << teShaderFile.rdbuf();
+                teShaderFile.close();
+                tessEvaluationCode = resolveIncludes(teShaderStream.str(), tessEvaluationPath);
+            }
+            catch (std::ifstream::failure e) {
+                std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: TESS_EVALUATION" << std::endl;
+            }
+        }
+
         // Geometry Shader
         if (geometryPath != nullptr) {
             std::ifstream gShaderFile;
@@ -67,7 +108,7 @@ public:
                 std::stringstream gShaderStream;
                 gShaderStream << gShaderFile.rdbuf();
                 gShaderFile.close();
-                geometryCode = gShaderStream.str();
+                geometryCode = resolveIncludes(gShaderStream.str(), geometryPath);
             }
             catch (std::ifstream::failure e) {
                 std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: GEOMETRY" << std::endl;
@@ -83,7 +124,7 @@ public:
                 std::stringstream fShaderStream;
                 fShaderStream << fShaderFile.rdbuf();
                 fShaderFile.close();
-                fragmentCode = fShaderStream.str();
+                fragmentCode = resolveIncludes(fShaderStream.str(), fragmentPath);
             }
             catch (std::ifstream::failure e) {
                 std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: FRAGMENT" << std::endl;
@@ -91,7 +132,7 @@ public:
         }
 
         // 2. compile shaders
-        unsigned int compute = 0, vertex = 0, geometry = 0, fragment = 0;
+        unsigned int compute = 0, vertex = 0, tessControl = 0, tessEvaluation = 0, geometry = 0, fragment = 0;
 
         // Compute Shader
         if (computePath != nullptr) {
@@ -111,6 +152,24 @@ public:
             checkCompileErrors(vertex, "VERTEX");
         }
 
+        // Tessellation Control Shader
+        if (tessControlPath != nullptr) {
+            const char* tcShaderCode = tessControlCode.c_str();
+            tessControl = glCreateShader(GL_TESS_CONTROL_SHADER);
+            glShaderSource(tessControl, 1, &tcShaderCode, NULL);
+            glCompileShader(tessControl);
+            checkCompileErrors(tessControl, "TESS_CONTROL");
+        }
+
+        // Tessellation Evaluation Shader
+        if (tessEvaluationPath != nullptr) {
+            const char* teShaderCode = tessEvaluationCode.c_str();
+            tessEvaluation = glCreateShader(GL_TESS_EVALUATION_SHADER);
+            glShaderSource(tessEvaluation, 1, &teShaderCode, NULL);
+            glCompileShader(tessEvaluation);
+            checkCompileErrors(tessEvaluation, "TESS_EVALUATION");
+        }
+
         // Geometry Shader
         if (geometryPath != nullptr) {
             const char* gShaderCode = geometryCode.c_str();
@@ -133,6 +192,8 @@ public:
         ID = glCreateProgram();
         if (computePath != nullptr) glAttachShader(ID, compute);
         if (vertexPath != nullptr) glAttachShader(ID, vertex);
+        if (tessControlPath != nullptr) glAttachShader(ID, tessControl);
+        if (tessEvaluationPath != nullptr) glAttachShader(ID, tessEvaluation);
         if (geometryPath != nullptr) glAttachShader(ID, geometry);
         if (fragmentPath != nullptr) glAttachShader(ID, fragment);
         glLinkProgram(ID);
@@ -141,6 +202,8 @@ public:
         // Delete the shaders as they're linked into our program now and no longer necessary
         if (computePath != nullptr) glDeleteShader(compute);
         if (vertexPath != nullptr) glDeleteShader(vertex);
+        if (tessControlPath != nullptr) glDeleteShader(tessControl);
+        if (tessEvaluationPath != nullptr) glDeleteShader(tessEvaluation);
         if (geometryPath != nullptr) glDeleteShader(geometry);
         if (fragmentPath != nullptr) glDeleteShader(fragment);
     }
@@ -184,6 +247,45 @@ public:
     }
 
 private:
+    // replaces lines of the form #include "file" with the contents of file,
+    // resolved relative to the directory of the including shader
+    // ------------------------------------------------------------------------
+    static std::string resolveIncludes(const std::string& code, const std::string& path)
+    {
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        std::stringstream input(code);
+        std::stringstream output;
+        std::string line;
+        while (std::getline(input, line))
+        {
+            size_t start = line.find("#include");
+            if (start == std::string::npos || line.find_first_not_of(" \t") != start)
+            {
+                output << line << '\n';
+                continue;
+            }
+            size_t open = line.find('"', start);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos)
+            {
+                output << line << '\n'; // malformed, let the GLSL compiler report it
+                continue;
+            }
+            std::string includePath = directory + line.substr(open + 1, close - open - 1);
+
+            std::ifstream includeFile(includePath);
+            if (!includeFile)
+            {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << includePath << std::endl;
+                continue;
+            }
+            std::stringstream includeStream;
+            includeStream << includeFile.rdbuf();
+            output << resolveIncludes(includeStream.str(), includePath) << '\n';
+        }
+        return output.str();
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type)
@@ -0,0 +1,136 @@
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include <cstddef>
+#include <new>
+
+// Vectorised math shared by the SIMD kernels. SSE2 is the x86-64 baseline and
+// always compiled in when available. The AVX2 functions are compiled for
+// AVX2 + FMA through SIMD_TARGET_AVX2 and may only run after CpuFeatures says so.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#ifdef SIMD_SSE2
+#define SIMD_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
+#endif
+
+// Cody-Waite reduction by pi/2 in three parts and minimax polynomials on
+// [-pi/4, pi/4], ~1e-7 error for |x| < 1e4
+#define SIMD_PIO2_INV 0.636619772f
+#define SIMD_PIO2_1 1.5703125f
+#define SIMD_PIO2_2 4.837512969970703125e-4f
+#define SIMD_PIO2_3 7.54978995489188216e-8f
+#define SIMD_SIN_C1 -1.6666654611e-1f
+#define SIMD_SIN_C2 8.3321608736e-3f
+#define SIMD_SIN_C3 -1.9515295891e-4f
+#define SIMD_COS_C1 4.166664568298827e-2f
+#define SIMD_COS_C2 -1.388731625493765e-3f
+#define SIMD_COS_C3 2.443315711809948e-5f
+
+#ifdef SIMD_SSE2
+// sin and cos of four angles
+inline void simdSinCos4(__m128 x, __m128& s, __m128& c)
+{
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(SIMD_PIO2_INV)));
+    __m128 qf = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(SIMD_PIO2_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(SIMD_PIO2_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(SIMD_PIO2_3)));
+    __m128 r2 = _mm_mul_ps(r, r);
+
+    __m128 sp = _mm_add_ps(_mm_set1_ps(SIMD_SIN_C2), _mm_mul_ps(r2, _mm_set1_ps(SIMD_SIN_C3)));
+    sp = _mm_add_ps(_mm_set1_ps(SIMD_SIN_C1), _mm_mul_ps(r2, sp));
+    sp = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), sp));
+
+    __m128 cp = _mm_add_ps(_mm_set1_ps(SIMD_COS_C2), _mm_mul_ps(r2, _mm_set1_ps(SIMD_COS_C3)));
+    cp = _mm_add_ps(_mm_set1_ps(SIMD_COS_C1), _mm_mul_ps(r2, cp));
+    cp = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), cp));
+
+    // quadrant q: odd swaps sin and cos, q & 2 negates sin, (q + 1) & 2 negates cos
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cp), _mm_andnot_ps(swap, sp)), sinSign);
+    c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sp), _mm_andnot_ps(swap, cp)), cosSign);
+}
+
+inline __m128 simdSin4(__m128 x)
+{
+    __m128 s, c;
+    simdSinCos4(x, s, c);
+    return s;
+}
+#endif
+
+#ifdef SIMD_AVX2
+// same as simdSinCos4, eight angles
+SIMD_TARGET_AVX2 inline void simdSinCos8(__m256 x, __m256& s, __m256& c)
+{
+    __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(SIMD_PIO2_INV)));
+    __m256 qf = _mm256_cvtepi32_ps(q);
+    __m256 r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(SIMD_PIO2_1), x);
+    r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(SIMD_PIO2_2), r);
+    r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(SIMD_PIO2_3), r);
+    __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 sp = _mm256_fmadd_ps(r2, _mm256_set1_ps(SIMD_SIN_C3), _mm256_set1_ps(SIMD_SIN_C2));
+    sp = _mm256_fmadd_ps(r2, sp, _mm256_set1_ps(SIMD_SIN_C1));
+    sp = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), sp, r);
+
+    __m256 cp = _mm256_fmadd_ps(r2, _mm256_set1_ps(SIMD_COS_C3), _mm256_set1_ps(SIMD_COS_C2));
+    cp = _mm256_fmadd_ps(r2, cp, _mm256_set1_ps(SIMD_COS_C1));
+    cp = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), cp, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1.0f)));
+
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    s = _mm256_xor_ps(_mm256_blendv_ps(sp, cp, swap), sinSign);
+    c = _mm256_xor_ps(_mm256_blendv_ps(cp, sp, swap), cosSign);
+}
+
+SIMD_TARGET_AVX2 inline __m256 simdSin8(__m256 x)
+{
+    __m256 s, c;
+    simdSinCos8(x, s, c);
+    return s;
+}
+#endif
+
+// std::allocator with a fixed alignment, for arrays the SIMD kernels load with aligned loads
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() {}
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+#endif
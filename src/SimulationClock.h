@@ -0,0 +1,76 @@
+#ifndef SIMULATION_CLOCK_H
+#define SIMULATION_CLOCK_H
+
+// Fixed-timestep clock. Real time is sampled once per frame with tick(), the
+// simulation then advances in whole steps of 1 / rate:
+//
+//     clock.tick(glfwGetTime());
+//     while (clock.step())
+//         simulate(clock.stepTime());
+//     render(clock.alpha());
+//
+// Step times are multiples of the step duration, so the simulation output does
+// not depend on the frame rate. Rendering blends the last two steps with
+// alpha() and sees time as renderTime(), which runs one step behind.
+class SimulationClock
+{
+public:
+    SimulationClock(double rate, unsigned int maxStepsPerFrame = 4)
+    {
+        this->stepDuration = 1.0 / rate;
+        this->maxStepsPerFrame = maxStepsPerFrame;
+        lastFrame = -1.0;
+        frame = 0.0;
+        delta = 0.0;
+        accumulator = 0.0;
+        steps = 0;
+        stepsThisFrame = 0;
+    }
+
+    void tick(double now)
+    {
+        delta = lastFrame < 0.0 ? 0.0 : now - lastFrame;
+        lastFrame = now;
+        frame = now;
+        accumulator += delta;
+        // a long stall would otherwise be caught up in one burst of steps,
+        // the simulation slows down instead
+        double maxBacklog = maxStepsPerFrame * stepDuration;
+        if (accumulator > maxBacklog)
+            accumulator = maxBacklog;
+        stepsThisFrame = 0;
+    }
+
+    // true while another step is due this frame, advances stepTime()
+    bool step()
+    {
+        if (accumulator < stepDuration)
+            return false;
+        accumulator -= stepDuration;
+        steps++;
+        stepsThisFrame++;
+        return true;
+    }
+
+    double stepTime() const { return steps * stepDuration; }
+    float stepLength() const { return (float)stepDuration; }
+    unsigned int stepCount() const { return steps; }
+    unsigned int stepsTaken() const { return stepsThisFrame; } // this frame
+
+    // 0 - previous step, 1 - latest step
+    float alpha() const { return (float)(accumulator / stepDuration); }
+    double renderTime() const { return stepTime() - stepDuration + accumulator; }
+
+    // real time of the current frame and since the previous one, for input and profiling
+    double frameTime() const { return frame; }
+    float frameDelta() const { return (float)delta; }
+
+private:
+    double stepDuration;
+    unsigned int maxStepsPerFrame;
+    double lastFrame, frame, delta;
+    double accumulator;
+    unsigned int steps, stepsThisFrame;
+};
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <GLAD/glad.h>
+#include <stb_image.h>
+
+#include "AssetCache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One mip level of a baked texture, pixels point into the mapped file
+struct TextureLevel {
+    uint32_t width, height;
+    const unsigned char* pixels; // rows of width * channels bytes, no padding
+};
+
+// A texture read for upload: the baked levels when the cache is current,
+// otherwise the level stb_image decoded and, when asked for, its mips
+struct TextureData {
+    std::string path;
+    uint32_t channels = 0;
+    std::vector<TextureLevel> levels; // empty when the texture couldn't be read
+    std::unique_ptr<MappedFile> file;
+    std::unique_ptr<unsigned char, void (*)(void*)> decoded{ nullptr, stbi_image_free };
+    std::vector<std::vector<unsigned char>> mips; // the levels after the decoded one
+};
+
+// Pre-decoded textures: the baked file <source>.texcache (see AssetCache)
+// holds the 8-bit pixels of the image as stb_image decodes it, not flipped,
+// with the whole mip chain down to 1x1 already filtered. The app uploads the
+// levels as they are, so neither the decode nor glGenerateMipmap runs at load.
+//
+// Layout, little endian: CacheHeader, then every level from the largest, each
+// padded to 4 bytes.
+class TextureCache
+{
+public:
+    static constexpr uint32_t VERSION = 2;
+
+    static std::string cachePath(const std::string& sourcePath)
+    {
+        return AssetCache::bakedPath(sourcePath, ".texcache");
+    }
+
+    static bool isCurrent(const std::string& sourcePath)
+    {
+        MappedFile file;
+        return readHeader(sourcePath, file) != nullptr;
+    }
+
+    // Decodes the source with stb_image, builds the mip chain with a box
+    // filter and writes the cache; false with error set when it fails.
+    // Safe to call from several threads.
+    static bool bake(const std::string& sourcePath, std::string& error)
+    {
+        CacheHeader header;
+        if (!AssetCache::sourceKey(sourcePath, header.sourceSize, header.sourceHash)) {
+            error = "no such file";
+            return false;
+        }
+
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(false);
+        unsigned char* data = stbi_load(sourcePath.c_str(), &width, &height, &channels, 0);
+        if (data == nullptr) {
+            error = stbi_failure_reason();
+            return false;
+        }
+        header.width = (uint32_t)width;
+        header.height = (uint32_t)height;
+        header.channels = (uint32_t)channels;
+        header.levelCount = levelCount(header.width, header.height);
+
+        std::string path = cachePath(sourcePath);
+        std::ofstream file;
+        if (!AssetCache::openTemporary(path, file)) {
+            stbi_image_free(data);
+            error = "cannot write " + path;
+            return false;
+        }
+        file.write((const char*)&header, sizeof(header));
+
+        std::vector<unsigned char> level(data, data + (size_t)width * height * channels);
+        stbi_image_free(data);
+        uint32_t w = header.width, h = header.height;
+        for (uint32_t i = 0; i < header.levelCount; i++) {
+            AssetCache::writePadded(file, level.data(), level.size());
+            if (i + 1 < header.levelCount)
+                level = downsample(level.data(), w, h, channels);
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+        if (!AssetCache::commit(path, file)) {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // Maps the cache of sourcePath, false when there is none or it is stale.
+    // The levels are valid while file is open.
+    static bool load(const std::string& sourcePath, MappedFile& file, uint32_t& channels, std::vector<TextureLevel>& levels)
+    {
+        const CacheHeader* header = readHeader(sourcePath, file);
+        if (header == nullptr)
+            return false;
+
+        AssetCache::Reader reader{ file.data() + sizeof(CacheHeader), file.data() + file.size() };
+        levels.clear();
+        uint32_t w = header->width, h = header->height;
+        for (uint32_t i = 0; i < header->levelCount; i++) {
+            const unsigned char* pixels = reader.takePadded((size_t)w * h * header->channels);
+            if (pixels == nullptr) {
+                std::cout << "ERROR::TEXTURE_CACHE::DAMAGED: " << cachePath(sourcePath) << std::endl;
+                file.close();
+                return false;
+            }
+            levels.push_back({ w, h, pixels });
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+        channels = header->channels;
+        return true;
+    }
+
+    // Reads sourcePath for upload, from the cache when it is current and
+    // decoded with stb_image otherwise; a decoded texture gets its mip chain
+    // built here when mipmaps is set. Any thread, no GL calls.
+    static TextureData read(const std::string& sourcePath, bool mipmaps = false)
+    {
+        TextureData data;
+        data.path = sourcePath;
+        data.file.reset(new MappedFile());
+        if (load(sourcePath, *data.file, data.channels, data.levels))
+            return data;
+        data.file.reset();
+
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(false);
+        data.decoded.reset(stbi_load(sourcePath.c_str(), &width, &height, &channels, 0));
+        if (data.decoded) {
+            data.channels = (uint32_t)channels;
+            data.levels.push_back({ (uint32_t)width, (uint32_t)height, data.decoded.get() });
+        }
+        uint32_t count = data.decoded && mipmaps ? levelCount(width, height) : 0;
+        for (uint32_t i = 1; i < count; i++) {
+            const TextureLevel& last = data.levels.back();
+            data.mips.push_back(downsample(last.pixels, last.width, last.height, channels));
+            data.levels.push_back({ last.width > 1 ? last.width / 2 : 1, last.height > 1 ? last.height / 2 : 1, data.mips.back().data() });
+        }
+        return data;
+    }
+
+    // Uploads data to the bound texture target, every level or only the
+    // largest; the mips a decoded texture lacks are generated. False when the
+    // texture couldn't be read.
+    static bool upload(GLenum target, const TextureData& data, bool mipmaps)
+    {
+        if (data.levels.empty()) {
+            std::cout << "ERROR::TEXTURE::NOT_LOADED: " << data.path << std::endl;
+            return false;
+        }
+        GLenum format = pixelFormat(data.channels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows are tightly packed
+        for (size_t i = 0; i < (mipmaps ? data.levels.size() : 1); i++) {
+            const TextureLevel& level = data.levels[i];
+            glTexImage2D(target, (GLint)i, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, level.pixels);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (mipmaps && data.levels.size() == 1 && (data.levels[0].width > 1 || data.levels[0].height > 1))
+            glGenerateMipmap(target);
+        return true;
+    }
+
+    static GLenum pixelFormat(uint32_t channels)
+    {
+        const GLenum formats[] = { GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        return formats[channels];
+    }
+
+private:
+    struct CacheHeader {
+        char magic[4] = { 'M', 'N', 'W', 'T' };
+        uint32_t version = VERSION;
+        uint64_t sourceSize = 0;
+        uint64_t sourceHash = 0;
+        uint32_t width = 0, height = 0;
+        uint32_t channels = 0;
+        uint32_t levelCount = 0;
+    };
+    static_assert(sizeof(CacheHeader) == 40, "the header is written as is");
+
+    static const CacheHeader* readHeader(const std::string& sourcePath, MappedFile& file)
+    {
+        CacheHeader expected;
+        if (!AssetCache::sourceKey(sourcePath, expected.sourceSize, expected.sourceHash))
+            return nullptr;
+        if (!file.open(cachePath(sourcePath)))
+            return nullptr;
+
+        AssetCache::Reader reader{ file.data(), file.data() + file.size() };
+        const CacheHeader* header = reader.take<CacheHeader>(1);
+        if (header == nullptr || std::memcmp(header->magic, expected.magic, sizeof(header->magic)) != 0 ||
+            header->version != expected.version || header->sourceSize != expected.sourceSize ||
+            header->sourceHash != expected.sourceHash || header->channels < 1 || header->channels > 4 ||
+            header->levelCount != levelCount(header->width, header->height)) {
+            file.close();
+            return nullptr;
+        }
+        return header;
+    }
+
+    static uint32_t levelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t levels = 1;
+        while (width > 1 || height > 1) {
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    // the next mip level, each texel the average of up to 2x2 texels; with an
+    // odd size the last row or column is averaged into its neighbour's texel
+    static std::vector<unsigned char> downsample(const unsigned char* level, uint32_t width, uint32_t height, int channels)
+    {
+        uint32_t w = width > 1 ? width / 2 : 1;
+        uint32_t h = height > 1 ? height / 2 : 1;
+        std::vector<unsigned char> result((size_t)w * h * channels);
+        for (uint32_t y = 0; y < h; y++) {
+            uint32_t y0 = y * height / h, y1 = (y + 1) * height / h;
+            for (uint32_t x = 0; x < w; x++) {
+                uint32_t x0 = x * width / w, x1 = (x + 1) * width / w;
+                for (int c = 0; c < channels; c++) {
+                    uint32_t sum = 0;
+                    for (uint32_t sy = y0; sy < y1; sy++)
+                        for (uint32_t sx = x0; sx < x1; sx++)
+                            sum += level[((size_t)sy * width + sx) * channels + c];
+                    uint32_t count = (y1 - y0) * (x1 - x0);
+                    result[((size_t)y * w + x) * channels + c] = (unsigned char)((sum + count / 2) / count);
+                }
+            }
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <GLAD/glad.h>
+
+#include "AssetLoader.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Streams textures to the GPU through a ring of pixel buffer objects, so no
+// frame stalls on a large glTexImage2D:
+//
+//     streamer.stream(texture, GL_TEXTURE_2D, std::move(data), true);
+//     ... every frame on the GL thread:
+//     streamer.update(8 << 20);
+//
+// stream() only allocates the levels. update() maps the free slots of the ring
+// and a loader thread copies the next band of rows into the mapped memory,
+// from the decoded image or straight from the mapped TextureCache file. Once
+// the copy is done the slot is unmapped, glTexSubImage2D reads it on the GPU
+// and a fence tells when the slot can be mapped again.
+//
+// A texture goes up band by band across frames, from the smallest level to
+// the largest, and GL_TEXTURE_BASE_LEVEL follows the completed levels: a
+// mipmapped texture is blurry for a few frames instead of stalling one.
+//
+// GL 4.3 has no persistent mapping (glBufferStorage is 4.4), so a slot is
+// mapped unsynchronized for each copy and unmapped before its upload; the
+// fence is what makes the unsynchronized map safe.
+class TextureStreamer
+{
+public:
+    // slotSize bytes per slot; with no slots stream() uploads right away.
+    // The loader must outlive the streamer, see release() for the shutdown order.
+    TextureStreamer(AssetLoader& loader, unsigned int slotCount = 4, size_t slotSize = 4 << 20)
+        : loader(loader), slots(slotCount), slotSize(slotSize)
+    {
+        for (Slot& slot : slots) {
+            glGenBuffers(1, &slot.buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, slotSize, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    ~TextureStreamer()
+    {
+        release();
+    }
+
+    // GL thread, while the context is alive: waits for the copies in flight,
+    // unmaps and deletes the slots and drops what is still queued. Call it
+    // after AssetLoader::shutdown(), which stops new copies and uploads:
+    //
+    //     loader.shutdown();
+    //     streamer.release();
+    //     ... then the rest of the GL objects, then glfwTerminate()
+    //
+    // Safe to call twice; stream() uploads right away afterwards.
+    void release()
+    {
+        for (Slot& slot : slots) {
+            if (slot.state == SlotState::Filling) {
+                // a loader thread is still writing into the mapping
+                while (!slot.filled.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            if (slot.fence != 0)
+                glDeleteSync(slot.fence);
+            glDeleteBuffers(1, &slot.buffer);
+        }
+        if (!slots.empty())
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        slots.clear();
+        filling.clear();
+        requests.clear();
+    }
+
+    // GL thread: allocates the levels of texture and queues the pixels.
+    // target is GL_TEXTURE_2D or a cube map face; mipmaps streams every level
+    // data has, see TextureCache::read. The texture's parameters are the caller's.
+    void stream(GLuint texture, GLenum target, TextureData data, bool mipmaps)
+    {
+        glBindTexture(bindingTarget(target), texture);
+        // a row that doesn't fit a slot has to go up in one piece
+        if (slots.empty() || data.levels.empty() || (size_t)data.levels[0].width * data.channels > slotSize) {
+            TextureCache::upload(target, data, mipmaps);
+            return;
+        }
+
+        Request request;
+        request.texture = texture;
+        request.target = target;
+        request.format = TextureCache::pixelFormat(data.channels);
+        int levels = mipmaps ? (int)data.levels.size() : 1;
+        for (int i = 0; i < levels; i++) {
+            const TextureLevel& level = data.levels[i];
+            glTexImage2D(target, i, request.format, level.width, level.height, 0, request.format, GL_UNSIGNED_BYTE, nullptr);
+        }
+        if (bindingTarget(target) == GL_TEXTURE_2D) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        }
+        request.level = levels - 1;
+        request.data = std::make_shared<TextureData>(std::move(data));
+        if (idle())
+            start = Clock::now();
+        requests.push_back(std::move(request));
+    }
+
+    // GL thread: uploads the bands that are copied and starts copies of up to
+    // budget bytes (at least one band), true when nothing is left to stream
+    bool update(size_t budget)
+    {
+        // slots the GPU has finished reading
+        for (Slot& slot : slots) {
+            if (slot.state != SlotState::InFlight)
+                continue;
+            GLenum status = glClientWaitSync(slot.fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+                glDeleteSync(slot.fence);
+                slot.fence = 0;
+                slot.state = SlotState::Free;
+            }
+        }
+
+        // in the order the copies started, so a level is complete with its last band
+        while (!filling.empty() && filling.front()->filled.load(std::memory_order_acquire)) {
+            Slot& slot = *filling.front();
+            filling.pop_front();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            uploadBand(slot.band, nullptr); // offset 0 of the bound buffer
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot.band.data.reset();
+            slot.state = SlotState::InFlight;
+        }
+
+        size_t started = 0;
+        for (Slot& slot : slots) {
+            if (requests.empty() || (started > 0 && started >= budget))
+                break;
+            if (slot.state != SlotState::Free)
+                continue;
+            Band band = nextBand();
+            size_t size = (size_t)band.width * band.data->channels * band.rows;
+            const unsigned char* pixels = band.data->levels[band.level].pixels + (size_t)band.width * band.data->channels * band.row;
+            started += size;
+            streamed += size;
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (mapped == nullptr) {
+                std::cout << "ERROR::TEXTURE_STREAMER::MAP_FAILED: " << band.data->path << std::endl;
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                uploadBand(band, pixels);
+                continue;
+            }
+            slot.band = std::move(band);
+            slot.state = SlotState::Filling;
+            slot.filled.store(false, std::memory_order_relaxed);
+            filling.push_back(&slot);
+            std::atomic<bool>* filled = &slot.filled;
+            loader.run([mapped, pixels, size, filled]() {
+                std::memcpy(mapped, pixels, size);
+                filled->store(true, std::memory_order_release);
+            });
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // client memory uploads elsewhere must not read from a slot
+
+        if (streamed > 0 && idle()) {
+            std::cout << "textures streamed: " << streamed / double(1 << 20) << " MB in "
+                      << std::chrono::duration<double>(Clock::now() - start).count() << " s" << std::endl;
+            streamed = 0;
+        }
+        return idle();
+    }
+
+    // GL thread: streams everything queued before returning
+    void finish()
+    {
+        while (!update(SIZE_MAX))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool idle() const
+    {
+        return requests.empty() && filling.empty();
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // rows [row, row + rows) of one level
+    struct Band {
+        GLuint texture = 0;
+        GLenum target = GL_TEXTURE_2D;
+        GLenum format = GL_RGBA;
+        int level = 0;
+        uint32_t row = 0, rows = 0, width = 0;
+        bool lastOfLevel = false;
+        std::shared_ptr<TextureData> data; // the pixels stay valid until the band is uploaded
+    };
+
+    struct Request {
+        GLuint texture;
+        GLenum target;
+        GLenum format;
+        int level;        // the level being streamed, counts down to 0
+        uint32_t row = 0; // its next row
+        std::shared_ptr<TextureData> data;
+    };
+
+    enum class SlotState {
+        Free,     // unmapped, the GPU is done with it
+        Filling,  // mapped, a loader thread is copying a band in
+        InFlight  // unmapped, the upload may still read it until the fence signals
+    };
+
+    struct Slot {
+        GLuint buffer = 0;
+        SlotState state = SlotState::Free;
+        std::atomic<bool> filled{ false };
+        GLsync fence = 0;
+        Band band;
+    };
+
+    AssetLoader& loader;
+    std::vector<Slot> slots;
+    size_t slotSize;
+    std::deque<Request> requests;
+    std::deque<Slot*> filling;
+
+    Clock::time_point start;
+    size_t streamed = 0; // bytes since the streamer was last idle
+
+    static GLenum bindingTarget(GLenum target)
+    {
+        return target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z ? GL_TEXTURE_CUBE_MAP : target;
+    }
+
+    // takes as many rows of the front request as fit a slot
+    Band nextBand()
+    {
+        Request& request = requests.front();
+        const TextureLevel& level = request.data->levels[request.level];
+        size_t rowSize = (size_t)level.width * request.data->channels;
+
+        Band band;
+        band.texture = request.texture;
+        band.target = request.target;
+        band.format = request.format;
+        band.level = request.level;
+        band.row = request.row;
+        band.rows = (uint32_t)std::min<size_t>(level.height - request.row, slotSize / rowSize);
+        band.width = level.width;
+        band.data = request.data;
+
+        request.row += band.rows;
+        band.lastOfLevel = request.row == level.height;
+        if (band.lastOfLevel) {
+            request.level--;
+            request.row = 0;
+            if (request.level < 0)
+                requests.pop_front();
+        }
+        return band;
+    }
+
+    // pixels is client memory, or nullptr for the start of the bound slot
+    static void uploadBand(const Band& band, const unsigned char* pixels)
+    {
+        GLenum binding = bindingTarget(band.target);
+        glBindTexture(binding, band.texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows are tightly packed
+        glTexSubImage2D(band.target, band.level, 0, band.row, band.width, band.rows, band.format, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (band.lastOfLevel && binding == GL_TEXTURE_2D)
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, band.level);
+    }
+};
+
+#endif
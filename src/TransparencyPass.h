@@ -0,0 +1,133 @@
+#ifndef TRANSPARENCY_PASS_H
+#define TRANSPARENCY_PASS_H
+
+#include <GLAD/glad.h>
+
+#include "Shader.h"
+
+#include <iostream>
+
+// Weighted blended order-independent transparency (McGuire and Bavoil 2013).
+//
+//     transparency.begin(width, height);
+//     ... draw translucent geometry with a fragment shader that includes oit.glsl ...
+//     transparency.end();
+//
+// Between begin() and end() translucent fragments go into two targets instead
+// of the window: accum (RGBA16F) sums the premultiplied colors and alphas times
+// a depth weight, revealage (R8) multiplies up the (1 - alpha) of every fragment.
+// Both blends are commutative, so the geometry can be drawn in any order and
+// nothing has to be sorted. end() composites the weighted average color over
+// the window with the total coverage 1 - revealage.
+//
+// The opaque scene must be drawn first: begin() copies the window's depth into
+// the pass, so translucent fragments behind opaque ones are still rejected, and
+// depth writes are off until end().
+class TransparencyPass
+{
+public:
+    TransparencyPass(int width, int height)
+        : compositeShader(NULL, "resources/shaders/transparency/composite.vs.glsl", NULL, "resources/shaders/transparency/composite.fs.glsl")
+    {
+        glGenFramebuffers(1, &FBO);
+        glGenTextures(1, &accumTexture);
+        glGenTextures(1, &revealageTexture);
+        glGenRenderbuffers(1, &depthRBO);
+        glGenVertexArrays(1, &VAO); // the full-screen triangle comes from gl_VertexID
+        allocate(width, height);
+
+        compositeShader.use();
+        compositeShader.setInt("accumTexture", 0);
+        compositeShader.setInt("revealageTexture", 1);
+    }
+
+    ~TransparencyPass()
+    {
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteTextures(1, &accumTexture);
+        glDeleteTextures(1, &revealageTexture);
+        glDeleteRenderbuffers(1, &depthRBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // width, height - size of the window framebuffer, the targets follow it
+    void begin(int width, int height)
+    {
+        if (width != this->width || height != this->height)
+            allocate(width, height);
+
+        // depth of the opaque scene, the formats must match for the blit
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        const GLfloat accumClear[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const GLfloat revealageClear[] = { 1.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, accumClear);
+        glClearBufferfv(GL_COLOR, 1, revealageClear);
+
+        glDepthMask(GL_FALSE);
+        glBlendFunci(0, GL_ONE, GL_ONE);
+        glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    }
+
+    // composites the translucent layer over the window and restores the blending of the opaque passes
+    void end()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_DEPTH_TEST);
+
+        compositeShader.use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, accumTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, revealageTexture);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+    }
+
+private:
+    GLuint FBO, accumTexture, revealageTexture, depthRBO, VAO;
+    int width = 0, height = 0;
+    Shader compositeShader;
+
+    void allocate(int width, int height)
+    {
+        this->width = width;
+        this->height = height;
+
+        glBindTexture(GL_TEXTURE_2D, accumTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, revealageTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // same format as the default framebuffer's depth (GLFW asks for 24 bit depth, 8 bit stencil)
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, revealageTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+        const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, drawBuffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::TRANSPARENCY_PASS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+};
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef WATER_CLIPMAP_H
+#define WATER_CLIPMAP_H
+
+#include <GLAD/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Frustum.h"
+
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+// Compact water vertex, must match WaterVertex in grid.glsl. World xz is rebuilt
+// from the vertex index, so 8 bytes replace a vec4 position and a vec4 normal.
+struct WaterVertex {
+    float height;
+    unsigned int normal; // octahedral, 2x16-bit snorm
+};
+
+// How the clipmap topology reaches the GPU
+enum class WaterDrawMode {
+    Indexed,   // triangle list index buffer
+    IndexFree, // glDrawArrays, topology generated from gl_VertexID - no index buffer at all
+    Strip,     // one triangle strip per row, primitive restart between rows
+    Culled     // 16x16-cell tiles frustum culled on the GPU, one multi-draw-indirect call
+};
+
+// must match DrawCommand in grid_cull.cs.glsl
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Geometry clipmap for the water surface: nested square levels centred on the
+// camera, each with the same gridRes x gridRes vertex budget and twice the
+// vertex spacing of the previous one. Level 0 is a full grid, the other levels
+// are rings around the previous level. The vertex layout must match grid.glsl.
+//
+// The vertices are double-buffered for the fixed-step simulation: every step
+// (update()) writes a new buffer, and the vertex shader blends it with the one
+// from the step before.
+//
+// SSBO bindings: 0 - vertices of the latest step, 1 - vertices of the previous step,
+// 4 - indirect draw commands (Culled)
+// atomic counter binding: 0 - visible / culled tiles (Culled)
+class WaterClipmap
+{
+public:
+    unsigned int levels;
+    unsigned int gridRes;   // vertices per level side, must be 4k + 1
+    float spacing;          // vertex spacing of level 0
+    glm::vec2 center;
+    glm::vec2 previousCenter; // center of the previous step
+
+    // tile size of the Culled mode, (gridRes - 1) must be a multiple of 4 * TILE_CELLS
+    static const unsigned int TILE_CELLS = 16;
+
+    WaterClipmap(unsigned int levels, unsigned int gridRes, float spacing, WaterDrawMode drawMode = WaterDrawMode::Indexed)
+        : cullShader("resources/shaders/water/grid_cull.cs.glsl", NULL, NULL, NULL)
+    {
+        this->levels = levels;
+        this->gridRes = gridRes;
+        this->spacing = spacing;
+        this->center = glm::vec2(0.0f);
+        this->previousCenter = glm::vec2(0.0f);
+        this->drawMode = drawMode;
+
+        // heights and normals are generated by the compute kernels
+        glGenBuffers(2, vertexSSBO);
+        for (int i = 0; i < 2; i++) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, vertexSSBO[i]);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, vertexCount() * sizeof(WaterVertex), nullptr, GL_DYNAMIC_DRAW);
+        }
+        current = 0;
+
+        // no vertex attributes, the vertex shader uses gl_VertexID to read from the SSBO
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        EBO = 0;
+        commandBuffer = 0;
+        counterBuffer = 0;
+
+        if (drawMode == WaterDrawMode::Culled) {
+            if ((gridRes - 1) % (4 * TILE_CELLS) != 0)
+                std::cout << "WaterClipmap: culled draws need gridRes - 1 to be a multiple of " << 4 * TILE_CELLS << std::endl;
+
+            // one shared tile pattern, each draw command moves it with baseVertex
+            std::vector<unsigned int> indices;
+            buildTileIndices(indices);
+            fullCount = (unsigned int)indices.size();
+            ringCount = 0;
+
+            glGenBuffers(1, &EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+            glGenBuffers(1, &commandBuffer);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, tileSlotCount() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+            GLuint zero[2] = { 0, 0 };
+            glGenBuffers(1, &counterBuffer);
+            glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuffer);
+            glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(zero), zero, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+        }
+        else if (drawMode == WaterDrawMode::IndexFree) {
+            unsigned int cells = gridRes - 1;
+            fullCount = cells * cells * 6;
+            ringCount = (cells * cells - (cells / 2) * (cells / 2)) * 6;
+        }
+        else {
+            std::vector<unsigned int> indices;
+            bool strip = drawMode == WaterDrawMode::Strip;
+            if (strip) buildStrips(indices, false); else buildIndices(indices, false);
+            fullCount = (unsigned int)indices.size();
+            if (strip) buildStrips(indices, true); else buildIndices(indices, true);
+            ringCount = (unsigned int)indices.size() - fullCount;
+
+            glGenBuffers(1, &EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        }
+        glBindVertexArray(0);
+    }
+
+    ~WaterClipmap()
+    {
+        glDeleteBuffers(2, vertexSSBO);
+        if (EBO != 0)
+            glDeleteBuffers(1, &EBO);
+        if (commandBuffer != 0)
+            glDeleteBuffers(1, &commandBuffer);
+        if (counterBuffer != 0)
+            glDeleteBuffers(1, &counterBuffer);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // Starts a simulation step: the latest vertices become the previous ones and
+    // the grid follows the camera. The centre is snapped to the spacing of the
+    // coarsest level, so every level stays aligned with the one around it and
+    // vertices don't swim when the camera moves.
+    void update(const glm::vec3& cameraPos)
+    {
+        current = 1 - current;
+        previousCenter = center;
+        float snap = levelSpacing(levels - 1);
+        center = glm::vec2(std::floor(cameraPos.x / snap) * snap, std::floor(cameraPos.z / snap) * snap);
+    }
+
+    void setUniforms(Shader& shader) const
+    {
+        shader.setUInt("gridRes", gridRes);
+        shader.setFloat("gridSpacing", spacing);
+        shader.setVec2("gridCenter", center);
+        shader.setVec2("previousGridCenter", previousCenter);
+    }
+
+    void bindBuffers() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vertexSSBO[current]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, vertexSSBO[1 - current]);
+    }
+
+    // 16x16 work groups, one z slice per level
+    void dispatch() const
+    {
+        unsigned int groupCount = (gridRes + 15) / 16;
+        glDispatchCompute(groupCount, groupCount, levels);
+    }
+
+    // Reads the computed vertices back with their world xz and decoded normals, for
+    // validation. Stitched border vertices are left out, their height is an average.
+    void readVertices(std::vector<glm::vec2>& positions, std::vector<float>& heights, std::vector<glm::vec3>& normals) const
+    {
+        std::vector<WaterVertex> vertices(vertexCount());
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, vertexSSBO[current]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, vertices.size() * sizeof(WaterVertex), vertices.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        positions.clear();
+        heights.clear();
+        normals.clear();
+        unsigned int last = gridRes - 1;
+        for (unsigned int level = 0; level < levels; level++) {
+            for (unsigned int z = 0; z < gridRes; z++) {
+                for (unsigned int x = 0; x < gridRes; x++) {
+                    bool stitched = ((x == 0 || x == last) && (z & 1)) || ((z == 0 || z == last) && (x & 1));
+                    if (stitched)
+                        continue;
+                    // gridToWorld in grid.glsl
+                    glm::vec2 cell((float)x, (float)z);
+                    positions.push_back(center + (cell - (float)last * 0.5f) * levelSpacing(level));
+                    const WaterVertex& vertex = vertices[(level * gridRes + z) * gridRes + x];
+                    heights.push_back(vertex.height);
+                    normals.push_back(decodeNormal(vertex.normal));
+                }
+            }
+        }
+    }
+
+    // decodeNormal in grid.glsl
+    static glm::vec3 decodeNormal(unsigned int encoded)
+    {
+        // unpackSnorm2x16
+        float ex = glm::clamp((float)(short)(encoded & 0xffff) / 32767.0f, -1.0f, 1.0f);
+        float ey = glm::clamp((float)(short)(encoded >> 16) / 32767.0f, -1.0f, 1.0f);
+        glm::vec3 n(ex, 1.0f - std::fabs(ex) - std::fabs(ey), ey);
+        float t = glm::max(-n.y, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.z += n.z >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    // Culled mode only: tests every tile, including the highest possible wave,
+    // against the frustum of viewProjection and writes the indirect draw commands
+    void cull(const glm::mat4& viewProjection, float maxWaveHeight)
+    {
+        if (drawMode != WaterDrawMode::Culled)
+            return;
+
+        GLuint zero[2] = { 0, 0 };
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuffer);
+        glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(zero), zero);
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, counterBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, commandBuffer);
+
+        cullShader.use();
+        setUniforms(cullShader);
+        cullShader.setUInt("levels", levels);
+        cullShader.setUInt("tileCells", TILE_CELLS);
+        cullShader.setUInt("tileIndexCount", fullCount);
+        cullShader.setFloat("maxWaveHeight", maxWaveHeight);
+        Frustum(viewProjection).setUniforms(cullShader);
+        glDispatchCompute((tileSlotCount() + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT);
+    }
+
+    // Culled mode only: prints the visible / culled tile counters once per interval.
+    // Reading them back waits for the cull pass, so this is for profiling.
+    void reportCullStats(double now, double interval = 2.0)
+    {
+        if (drawMode != WaterDrawMode::Culled || now - lastCullReport < interval)
+            return;
+        lastCullReport = now;
+
+        GLuint counters[2];
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT); // the cull shader wrote the counters
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuffer);
+        glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(counters), counters);
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+        std::cout << "water tiles: " << counters[0] << " visible, " << counters[1] << " culled" << std::endl;
+    }
+
+    // shader is the water shader (grid.vs.glsl), already in use
+    void draw(Shader& shader) const
+    {
+        glBindVertexArray(VAO);
+        shader.setBool("indexFree", drawMode == WaterDrawMode::IndexFree);
+
+        if (drawMode == WaterDrawMode::Culled) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, tileSlotCount(), 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        else if (drawMode == WaterDrawMode::IndexFree) {
+            // level 0, then all rings as instances
+            shader.setUInt("firstLevel", 0);
+            shader.setBool("ring", false);
+            glDrawArrays(GL_TRIANGLES, 0, fullCount);
+            if (levels > 1) {
+                shader.setUInt("firstLevel", 1);
+                shader.setBool("ring", true);
+                glDrawArraysInstanced(GL_TRIANGLES, 0, ringCount, levels - 1);
+            }
+        }
+        else {
+            GLenum mode = GL_TRIANGLES;
+            if (drawMode == WaterDrawMode::Strip) {
+                mode = GL_TRIANGLE_STRIP;
+                glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+            }
+            glDrawElements(mode, fullCount, GL_UNSIGNED_INT, 0);
+            for (unsigned int level = 1; level < levels; level++)
+                glDrawElementsBaseVertex(mode, ringCount, GL_UNSIGNED_INT,
+                    (void*)(fullCount * sizeof(unsigned int)), level * gridRes * gridRes);
+            if (drawMode == WaterDrawMode::Strip)
+                glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        }
+        glBindVertexArray(0);
+    }
+
+    float levelSpacing(unsigned int level) const
+    {
+        return spacing * (float)(1u << level);
+    }
+
+    unsigned int vertexCount() const
+    {
+        return levels * gridRes * gridRes;
+    }
+
+    // indirect draw command slots of the Culled mode, every tile of every level
+    unsigned int tileSlotCount() const
+    {
+        unsigned int tilesPerSide = (gridRes - 1) / TILE_CELLS;
+        return levels * tilesPerSide * tilesPerSide;
+    }
+
+    unsigned int triangleCount() const
+    {
+        unsigned int cells = gridRes - 1;
+        unsigned int ringCells = cells * cells - (cells / 2) * (cells / 2);
+        return 2 * (cells * cells + (levels - 1) * ringCells);
+    }
+
+    // Startup benchmark of the three draw modes: simulated post-transform vertex
+    // cache (FIFO, cacheSize entries) and index buffer size. Frame time is measured
+    // separately with a GpuTimer around draw().
+    void printDrawModeStats(unsigned int cacheSize = 32) const
+    {
+        const char* names[] = { "indexed list", "strip + restart" };
+        for (int strip = 0; strip < 2; strip++) {
+            std::vector<unsigned int> indices;
+            if (strip) buildStrips(indices, false); else buildIndices(indices, false);
+            size_t full = indices.size();
+            if (strip) buildStrips(indices, true); else buildIndices(indices, true);
+
+            std::vector<unsigned int> fullIndices(indices.begin(), indices.begin() + full);
+            std::vector<unsigned int> ringIndices(indices.begin() + full, indices.end());
+            unsigned int fullFetches, ringFetches;
+            unsigned int misses = simulateVertexCache(fullIndices, cacheSize, fullFetches) + (levels - 1) * simulateVertexCache(ringIndices, cacheSize, ringFetches);
+            unsigned int fetches = fullFetches + (levels - 1) * ringFetches;
+
+            std::cout << "water " << names[strip] << ": " << (float)misses / triangleCount() << " ACMR, "
+                      << 100.0f * (1.0f - (float)misses / fetches) << "% cache hits, "
+                      << indices.size() * sizeof(unsigned int) / 1024 << " KB indices" << std::endl;
+        }
+        // no index buffer, every corner of every triangle is shaded
+        std::cout << "water index-free: 3 ACMR, 0% cache hits, 0 KB indices" << std::endl;
+    }
+
+private:
+    GLuint vertexSSBO[2];
+    unsigned int current; // vertexSSBO of the latest step
+    GLuint VAO, EBO;
+    WaterDrawMode drawMode;
+    unsigned int fullCount, ringCount; // indices, or vertices for index-free draws; tile indices for Culled
+
+    Shader cullShader;
+    GLuint commandBuffer, counterBuffer;
+    double lastCullReport = 0.0;
+
+    // one TILE_CELLS x TILE_CELLS tile with the level's row stride, placed by baseVertex
+    void buildTileIndices(std::vector<unsigned int>& indices) const
+    {
+        for (unsigned int z = 0; z < TILE_CELLS; ++z) {
+            for (unsigned int x = 0; x < TILE_CELLS; ++x) {
+                unsigned int topLeft = z * gridRes + x;
+                unsigned int bottomLeft = (z + 1) * gridRes + x;
+                indices.insert(indices.end(), { topLeft, bottomLeft, topLeft + 1, topLeft + 1, bottomLeft, bottomLeft + 1 });
+            }
+        }
+    }
+
+    // appends the triangle list of one level, the ring leaves out the middle
+    // half where the finer level is drawn
+    void buildIndices(std::vector<unsigned int>& indices, bool ring) const
+    {
+        unsigned int cells = gridRes - 1;
+        unsigned int holeStart = cells / 4;
+        unsigned int holeEnd = cells - cells / 4;
+
+        for (unsigned int z = 0; z < cells; ++z) {
+            for (unsigned int x = 0; x < cells; ++x) {
+                if (ring && x >= holeStart && x < holeEnd && z >= holeStart && z < holeEnd)
+                    continue;
+
+                unsigned int topLeft = z * gridRes + x;
+                unsigned int topRight = topLeft + 1;
+                unsigned int bottomLeft = (z + 1) * gridRes + x;
+                unsigned int bottomRight = bottomLeft + 1;
+
+                // First triangle
+                indices.push_back(topLeft);
+                indices.push_back(bottomLeft);
+                indices.push_back(topRight);
+
+                // Second triangle
+                indices.push_back(topRight);
+                indices.push_back(bottomLeft);
+                indices.push_back(bottomRight);
+            }
+        }
+    }
+
+    // same triangles as buildIndices as one strip per row (two per row next to
+    // the hole of a ring), separated by the primitive restart index
+    void buildStrips(std::vector<unsigned int>& indices, bool ring) const
+    {
+        const unsigned int restart = 0xFFFFFFFF; // GL_PRIMITIVE_RESTART_FIXED_INDEX for GL_UNSIGNED_INT
+        unsigned int cells = gridRes - 1;
+        unsigned int holeStart = cells / 4;
+        unsigned int holeEnd = cells - cells / 4;
+
+        for (unsigned int z = 0; z < cells; ++z) {
+            bool split = ring && z >= holeStart && z < holeEnd;
+            unsigned int spans[2][2] = { { 0, split ? holeStart : cells }, { holeEnd, cells } };
+            for (unsigned int s = 0; s < (split ? 2u : 1u); s++) {
+                for (unsigned int x = spans[s][0]; x <= spans[s][1]; ++x) {
+                    indices.push_back(z * gridRes + x);
+                    indices.push_back((z + 1) * gridRes + x);
+                }
+                indices.push_back(restart);
+            }
+        }
+    }
+
+    // number of vertex shader invocations for an index stream with a FIFO cache,
+    // fetches is the number of indices that aren't restarts
+    static unsigned int simulateVertexCache(const std::vector<unsigned int>& indices, unsigned int cacheSize, unsigned int& fetches)
+    {
+        std::deque<unsigned int> cache;
+        unsigned int misses = 0;
+        fetches = 0;
+        for (unsigned int index : indices) {
+            if (index == 0xFFFFFFFF)
+                continue;
+            fetches++;
+            bool hit = false;
+            for (unsigned int cached : cache)
+                if (cached == index) { hit = true; break; }
+            if (hit)
+                continue;
+            misses++;
+            cache.push_back(index);
+            if (cache.size() > cacheSize)
+                cache.pop_front();
+        }
+        return misses;
+    }
+};
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef WATER_HEIGHT_FIELD_H
+#define WATER_HEIGHT_FIELD_H
+
+#include <glm/glm.hpp>
+
+#include "SimdMath.h"
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// CPU side of the water wave model in wave.glsl, for everything that floats.
+// Heights and normals come from the same formulas as the compute kernels:
+// waveModel 0 - the sin*cos wave at a given time, waveModel 1 - bilinear
+// lookup of the FFT ocean height map (see OceanFFT::readHeights).
+//
+// Nothing should be sampled before hasWaves(): in FFT mode the first height
+// map only arrives a few frames in, see OceanFFT::readHeights.
+//
+// query() takes positions as separate x and z arrays and works on four of them
+// at a time with SSE2, so thousands of objects per frame cost next to nothing.
+class WaterHeightField
+{
+public:
+    // must match wave.glsl
+    static constexpr float SINE_FREQ = 0.5f;
+    static constexpr float SINE_AMP = 0.5f;
+
+    // how far the GPU may be from query() in compareWithGpu
+    static constexpr double GPU_HEIGHT_TOLERANCE = 1e-3;       // meters
+    static constexpr double GPU_NORMAL_TOLERANCE_DEGREES = 0.5;
+
+    WaterHeightField()
+    {
+        waveModel = 0;
+        time = 0.0f;
+        size = 0;
+        patchSize = 1.0f;
+        ready = false;
+    }
+
+    // waveModel 0 at the given time, the same value the kernels get as "time"
+    void setSineWave(float time)
+    {
+        waveModel = 0;
+        this->time = time;
+        ready = true;
+    }
+
+    // waveModel 1, heights is the size x size map with the sign already corrected.
+    // The map is swapped in rather than copied: heights gets the previous one
+    // back, to be filled with the next readback.
+    void setHeightMap(std::vector<float>& heights, unsigned int size, float patchSize)
+    {
+        waveModel = 1;
+        heightMap.swap(heights);
+        this->size = size;
+        this->patchSize = patchSize;
+        ready = true;
+    }
+
+    // false until a wave model has been set
+    bool hasWaves() const
+    {
+        return ready;
+    }
+
+    float height(float x, float z) const
+    {
+        float h;
+        query(&x, &z, 1, &h);
+        return h;
+    }
+
+    // heights[i] (and normals[i] when not null) at world (x[i], z[i])
+    void query(const float* x, const float* z, size_t count, float* heights, glm::vec3* normals = nullptr) const
+    {
+        size_t i = 0;
+#ifdef SIMD_SSE2
+        for (; i + 4 <= count; i += 4) {
+            __m128 h, gx, gz;
+            if (waveModel == 1)
+                fftHeightAndGradient4(_mm_loadu_ps(x + i), _mm_loadu_ps(z + i), h, gx, gz);
+            else
+                sineHeightAndGradient4(_mm_loadu_ps(x + i), _mm_loadu_ps(z + i), h, gx, gz);
+            _mm_storeu_ps(heights + i, h);
+
+            if (normals != nullptr) {
+                // normalize(-dh/dx, 1, -dh/dz)
+                __m128 one = _mm_set1_ps(1.0f);
+                __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(one, _mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gz, gz)))));
+                float nx[4], ny[4], nz[4];
+                _mm_storeu_ps(nx, _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), gx), invLength));
+                _mm_storeu_ps(ny, invLength);
+                _mm_storeu_ps(nz, _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), gz), invLength));
+                for (int lane = 0; lane < 4; lane++)
+                    normals[i + lane] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            glm::vec3 hg = waveModel == 1 ? fftHeightAndGradient(x[i], z[i]) : sineHeightAndGradient(x[i], z[i]);
+            heights[i] = hg.x;
+            if (normals != nullptr)
+                normals[i] = glm::normalize(glm::vec3(-hg.y, 1.0f, -hg.z));
+        }
+    }
+
+    // Prints how far the GPU results for the given positions are from query(),
+    // false (and FAILED) when it is more than the tolerances above. The normals
+    // are expected after their 16-bit octahedral round trip.
+    bool compareWithGpu(const std::vector<glm::vec2>& positions, const std::vector<float>& gpuHeights,
+                        const std::vector<glm::vec3>& gpuNormals, const char* label) const
+    {
+        size_t count = positions.size();
+        std::vector<float> x(count), z(count), heights(count);
+        std::vector<glm::vec3> normals(count);
+        for (size_t i = 0; i < count; i++) {
+            x[i] = positions[i].x;
+            z[i] = positions[i].y;
+        }
+        query(x.data(), z.data(), count, heights.data(), normals.data());
+
+        double maxHeightError = 0.0, sumSquares = 0.0, maxNormalAngle = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            double e = std::fabs(heights[i] - gpuHeights[i]);
+            maxHeightError = std::fmax(maxHeightError, e);
+            sumSquares += e * e;
+            float cosAngle = glm::clamp(glm::dot(normals[i], glm::normalize(gpuNormals[i])), -1.0f, 1.0f);
+            maxNormalAngle = std::fmax(maxNormalAngle, glm::degrees(std::acos(cosAngle)));
+        }
+        std::cout << "water height field vs GPU (" << label << ", " << count << " points): max height error " << maxHeightError
+                  << ", rms " << std::sqrt(sumSquares / (count > 0 ? count : 1)) << ", max normal error " << maxNormalAngle << " deg" << std::endl;
+        bool passed = count > 0 && maxHeightError <= GPU_HEIGHT_TOLERANCE && maxNormalAngle <= GPU_NORMAL_TOLERANCE_DEGREES;
+        if (!passed)
+            std::cout << "FAILED: water height field vs GPU (" << label << "), allowed " << GPU_HEIGHT_TOLERANCE << " m and "
+                      << GPU_NORMAL_TOLERANCE_DEGREES << " deg" << std::endl;
+        return passed;
+    }
+
+private:
+    unsigned int waveModel;
+    float time;
+    std::vector<float> heightMap;
+    unsigned int size;
+    float patchSize;
+    bool ready;
+
+    // sineWaveHeightAndGradient in wave.glsl - x height, yz gradient
+    glm::vec3 sineHeightAndGradient(float x, float z) const
+    {
+        float sx = std::sin(x * SINE_FREQ + time);
+        float cx = std::cos(x * SINE_FREQ + time);
+        float sz = std::sin(z * SINE_FREQ + time);
+        float cz = std::cos(z * SINE_FREQ + time);
+        return glm::vec3(sx * cz, cx * cz * SINE_FREQ, -sx * sz * SINE_FREQ) * SINE_AMP;
+    }
+
+    float texel(int cx, int cz) const
+    {
+        int mask = (int)size - 1;
+        return heightMap[(cz & mask) * size + (cx & mask)];
+    }
+
+    // fftWaveHeightAndGradient in wave.glsl
+    glm::vec3 fftHeightAndGradient(float x, float z) const
+    {
+        float u = x / patchSize * size;
+        float v = z / patchSize * size;
+        int cx = (int)std::floor(u);
+        int cz = (int)std::floor(v);
+        float fx = u - cx;
+        float fz = v - cz;
+
+        float h00 = texel(cx, cz);
+        float h10 = texel(cx + 1, cz);
+        float h01 = texel(cx, cz + 1);
+        float h11 = texel(cx + 1, cz + 1);
+
+        float height = glm::mix(glm::mix(h00, h10, fx), glm::mix(h01, h11, fx), fz);
+        glm::vec2 gradient(glm::mix(h10 - h00, h11 - h01, fz), glm::mix(h01 - h00, h11 - h10, fx));
+        return glm::vec3(height, gradient * ((float)size / patchSize));
+    }
+
+#ifdef SIMD_SSE2
+    void sineHeightAndGradient4(__m128 x, __m128 z, __m128& h, __m128& gx, __m128& gz) const
+    {
+        __m128 freq = _mm_set1_ps(SINE_FREQ);
+        __m128 t = _mm_set1_ps(time);
+        __m128 sx, cx, sz, cz;
+        simdSinCos4(_mm_add_ps(_mm_mul_ps(x, freq), t), sx, cx);
+        simdSinCos4(_mm_add_ps(_mm_mul_ps(z, freq), t), sz, cz);
+
+        __m128 amp = _mm_set1_ps(SINE_AMP);
+        __m128 gradientScale = _mm_set1_ps(SINE_FREQ * SINE_AMP);
+        h = _mm_mul_ps(_mm_mul_ps(sx, cz), amp);
+        gx = _mm_mul_ps(_mm_mul_ps(cx, cz), gradientScale);
+        gz = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(_mm_mul_ps(sx, sz), gradientScale));
+    }
+
+    // floor without SSE4.1: truncate, then step down where truncation went up
+    static __m128i floor4(__m128 v)
+    {
+        __m128i i = _mm_cvttps_epi32(v);
+        return _mm_add_epi32(i, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(i), v)));
+    }
+
+    // the texel fetches are scalar, the interpolation is four-wide
+    void fftHeightAndGradient4(__m128 x, __m128 z, __m128& h, __m128& gx, __m128& gz) const
+    {
+        // x / patchSize * size in this order, like wave.glsl: x * (size / patchSize)
+        // rounds differently and moves the lookup by up to ~1e-5 of a texel
+        __m128 patch = _mm_set1_ps(patchSize);
+        __m128 texels = _mm_set1_ps((float)size);
+        __m128 texelsPerUnit = _mm_set1_ps((float)size / patchSize);
+        __m128 u = _mm_mul_ps(_mm_div_ps(x, patch), texels);
+        __m128 v = _mm_mul_ps(_mm_div_ps(z, patch), texels);
+        __m128i cx = floor4(u);
+        __m128i cz = floor4(v);
+        __m128 fx = _mm_sub_ps(u, _mm_cvtepi32_ps(cx));
+        __m128 fz = _mm_sub_ps(v, _mm_cvtepi32_ps(cz));
+
+        int ix[4], iz[4];
+        _mm_storeu_si128((__m128i*)ix, cx);
+        _mm_storeu_si128((__m128i*)iz, cz);
+        float t00[4], t10[4], t01[4], t11[4];
+        for (int lane = 0; lane < 4; lane++) {
+            t00[lane] = texel(ix[lane], iz[lane]);
+            t10[lane] = texel(ix[lane] + 1, iz[lane]);
+            t01[lane] = texel(ix[lane], iz[lane] + 1);
+            t11[lane] = texel(ix[lane] + 1, iz[lane] + 1);
+        }
+        __m128 h00 = _mm_loadu_ps(t00), h10 = _mm_loadu_ps(t10), h01 = _mm_loadu_ps(t01), h11 = _mm_loadu_ps(t11);
+
+        __m128 top = mix4(h00, h10, fx);
+        __m128 bottom = mix4(h01, h11, fx);
+        h = mix4(top, bottom, fz);
+        gx = _mm_mul_ps(mix4(_mm_sub_ps(h10, h00), _mm_sub_ps(h11, h01), fz), texelsPerUnit);
+        gz = _mm_mul_ps(mix4(_mm_sub_ps(h01, h00), _mm_sub_ps(h11, h10), fx), texelsPerUnit);
+    }
+
+    static __m128 mix4(__m128 a, __m128 b, __m128 t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef WATER_PATCH_GRID_H
+#define WATER_PATCH_GRID_H
+
+#include <GLAD/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Frustum.h"
+
+#include <cmath>
+
+// Tessellated water: a coarse grid of quad patches centred on the camera, drawn
+// with the patch.*.glsl shaders. The control shader picks tessellation levels
+// from the screen-space size of every patch edge and the evaluation shader
+// samples wave.glsl, so triangle density follows the view without any CPU LOD
+// work and no vertex buffer is written per frame - the FFT height field (or the
+// sine wave) is read directly.
+//
+// Like WaterClipmap there are no vertex attributes, patch corners come from gl_VertexID.
+class WaterPatchGrid
+{
+public:
+    unsigned int patchesPerSide;
+    float patchSize;        // world-space width of one patch
+    float pixelsPerEdge;    // target length of a tessellated edge on screen
+    float maxWaveHeight;    // patch bounds for culling in the control shader
+    glm::vec2 center;
+
+    WaterPatchGrid(unsigned int patchesPerSide, float patchSize, float pixelsPerEdge = 8.0f)
+    {
+        this->patchesPerSide = patchesPerSide;
+        this->patchSize = patchSize;
+        this->pixelsPerEdge = pixelsPerEdge;
+        this->maxWaveHeight = 0.0f;
+        this->center = glm::vec2(0.0f);
+
+        glGenVertexArrays(1, &VAO);
+    }
+
+    ~WaterPatchGrid()
+    {
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // follows the camera in whole patches, so tessellated vertices only move with the LOD
+    void update(const glm::vec3& cameraPos)
+    {
+        center = glm::vec2(std::floor(cameraPos.x / patchSize) * patchSize, std::floor(cameraPos.z / patchSize) * patchSize);
+    }
+
+    // shader is the tessellated water shader, already in use
+    void setUniforms(Shader& shader, const glm::mat4& projection, const glm::mat4& view, float viewportHeight) const
+    {
+        shader.setUInt("patchesPerSide", patchesPerSide);
+        shader.setFloat("patchWidth", patchSize);
+        shader.setVec2("patchGridCenter", center);
+        shader.setFloat("maxWaveHeight", maxWaveHeight);
+        // an edge of length l at distance d covers about l / d * lodScale target edges
+        shader.setFloat("lodScale", projection[1][1] * 0.5f * viewportHeight / pixelsPerEdge);
+        Frustum(projection * view).setUniforms(shader);
+    }
+
+    void draw() const
+    {
+        glBindVertexArray(VAO);
+        glPatchParameteri(GL_PATCH_VERTICES, 4);
+        glDrawArrays(GL_PATCHES, 0, patchesPerSide * patchesPerSide * 4);
+        glBindVertexArray(0);
+    }
+
+private:
+    GLuint VAO;
+};
+
+#endif
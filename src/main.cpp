@@ -6,7 +6,7 @@
 
 #include <iostream>
 #include <vector>
-#include <random>
+#include <chrono>
 
 #include "stb_image.h"
 
@@ -14,9 +14,26 @@
 #include "Texture2D.h"
 #include "SingleMesh.h"
 #include "Model.h"
-
-
-// Particle
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "AssetLoader.h"
+#include "MemoryUsage.h"
+#include "OceanFFT.h"
+#include "GpuTimer.h"
+#include "WaterClipmap.h"
+#include "WaterPatchGrid.h"
+#include "WaterHeightField.h"
+#include "SimulationClock.h"
+#include "ParticleSystem.h"
+#include "ParticleEmitter.h"
+#include "GpuParticleSystem.h"
+#include "ParticleRenderer.h"
+#include "TransparencyPass.h"
+#include "JobSystem.h"
+#include "Random.h"
+
+
+// Particle in array-of-structures layout, kept as the baseline of benchmarkParticleUpdate
 struct Particle {
     glm::vec3 Position, Velocity;
     glm::vec4 Color;
@@ -38,11 +55,8 @@ struct DirLight {
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void processInput(GLFWwindow* window);
-bool compute_probability(double probability);
-unsigned int FirstUnusedWindParticle();
-void RespawnParticle(Particle& particle);
-float getRandomFloat(float min, float max);
-float rand_normal();
+int runScene(GLFWwindow* window);
+void benchmarkParticleUpdate(const WindParticleParams& params);
 
 const unsigned int SCR_WIDTH = 1600;
 const unsigned int SCR_HEIGHT = 1200;
@@ -59,12 +73,12 @@ float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 float fov = 60.0f;
 
-std::default_random_engine generator;
-std::normal_distribution<float> distribution(0.0f, 1.0f);
+// every random number comes from a RandomStream under this seed, the same seed replays the same run
+const unsigned int randomSeed = 1;
 
 // timing 
 float deltaTime = 0.0f;	// Time between current frame and last frame
-float lastFrame = 0.0f; // Time of last frame
+SimulationClock simulationClock(30.0); // fixed simulation steps per second
 
 // wind
 float largeScaleWindMaxAngle = 25.0f;
@@ -75,29 +89,67 @@ float sideAmplitude = 0.4f; // how much the particle go to sides
 glm::vec3 windDirection = glm::normalize(glm::vec3(-1.0f, 0.0f, -1.0f));
 glm::vec3 north = glm::vec3(0, 0, 1);
 
-std::vector<Particle> windParticles;
 unsigned int windParticlesNumber = 500;
-unsigned int lastUsedWindParticle = 0;
-float windParticleSpawnProbability = 0.004f;
+ParticleSystem windParticles(windParticlesNumber);
 float windParticleLife = 9.0f;
-
-// water
-const int waterGridRes = 300; // Grid resolution
-const int waterGridSize = 1000; // Width/height of the grid
-std::vector<glm::vec4> waterVertices;
-std::vector<glm::vec4> waterNormals(waterGridRes* waterGridRes);
-std::vector<unsigned int> waterIndices;
+// the spawn rate used to be a 0.004 chance per frame, this is the same at 60 fps
+ParticleEmitter windEmitter(0.24f, 64); // particles per second, most particles per frame
+// the GPU system emits at its own rate, its pool holds a full lifetime of it (~180k particles)
+ParticleEmitter windGpuEmitter(20000.0f, 2048);
+bool windParticlesOnGpu = true; // GpuParticleSystem, otherwise the CPU ParticleSystem windParticles
+bool particleBenchmark = false; // times the AoS particle loop against the ParticleSystem kernels at startup
+const unsigned int particleJobGrain = 4096; // CPU particles per job, a multiple of ParticleSystem::SIMD_GROUP
+
+// per-frame CPU work runs on the JobSystem
+bool jobTrace = false; // writes the jobs of frame 100 to job_trace.json, open it in chrome://tracing
+bool windParticlesSorted = true; // without OIT, GPU particles are sorted back to front before they are blended
+bool windParticleStreaks = false; // stretches the particle quads along their screen-space velocity
+const float windStreakLength = 0.1f; // seconds of motion a streak covers
+bool windParticlesOit = true; // weighted blended OIT through TransparencyPass, no sort needed; otherwise blended in draw order
+
+// asset loading - models and textures load on AssetLoader threads while frames are drawn
+bool asyncLoading = true; // otherwise the first frame waits for every asset
+const double assetUploadBudget = 0.004; // seconds of GL uploads per frame while assets load
+bool streamTextures = true; // through TextureStreamer's PBO ring across frames, otherwise each texture in one upload
+const size_t textureStreamBudget = 8 << 20; // bytes of texture copies started per frame
+
+// water - clipmap levels centred on the camera, see WaterClipmap
+const int waterGridRes = 129; // vertices per level side, must be 4k + 1
+const int waterClipmapLevels = 4; // covers +-256 units, beyond the far plane
+const float waterGridSpacing = 0.5f; // vertex spacing near the camera, doubles every level
+bool waterUseFFT = true; // FFT ocean, otherwise the single sin*cos wave of wave.glsl
+
+// how water heights and normals are computed each frame
+enum class WaterCompute {
+    TwoPass,  // grid_height + grid_normals (finite differences), two dispatches
+    Fused,    // grid_fused - heights and normals from one tiled dispatch
+    Analytic  // grid_height writes the closed-form normal, no normals pass
+};
+WaterCompute waterCompute = WaterCompute::Analytic;
+WaterDrawMode waterDrawMode = WaterDrawMode::Culled;
+bool waterBenchmark = false; // prints vertex cache statistics of every draw mode at startup
+bool waterValidate = false; // compares WaterHeightField with a GPU readback of both wave models at startup, exits with 1 when they differ
+// tessellated patches instead of the clipmap, see WaterPatchGrid
+bool waterTessellated = false;
+const int waterPatchesPerSide = 64;
+const float waterPatchSize = 8.0f; // 64 patches of 8 units cover the same +-256 units as the clipmap
 
 float boatRotate = 0.0f;
 bool boatMove = false;
 const float ROTATION_SPEED = 0.08f;
 const float MOVE_SPEED = 0.025f;
 
+// CPU copy of the wave model the water is rendered with, updated every frame
+WaterHeightField waterHeightField;
+const float BOAT_FLOAT_OFFSET = 0.37f; // lifts the hull so the deck stays above the waterline
+
 float boatHeight(glm::mat4 boatMatrix)
 {
-    float freq = 0.5;
+    // in FFT mode the boat rests at sea level until the first heights are read back
+    if (!waterHeightField.hasWaves())
+        return BOAT_FLOAT_OFFSET;
 	// boatMatrix[3] - the translation vector of the boat in world space
-    return sin(boatMatrix[3].x * freq + glfwGetTime()) * cos(boatMatrix[3].z * freq + glfwGetTime()) + 0.37;
+    return waterHeightField.height(boatMatrix[3].x, boatMatrix[3].z) + BOAT_FLOAT_OFFSET;
 }
 
 glm::vec3 boatPos = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -130,6 +182,7 @@ int main()
     glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     // Enables Cull Facing
     //glEnable(GL_CULL_FACE);
     // Keeps front faces
@@ -137,31 +190,76 @@ int main()
     // Uses counter clock-wise standard
     //glFrontFace(GL_CCW);
 
+    int status = runScene(window);
+
+    glfwTerminate();
+    return status;
+}
+
+// ----------------------------------------------------------------
+
+// Everything that owns GL objects is local to this function, so the
+// destructors run while the context still exists, before glfwTerminate().
+// Returns the exit status, non-zero when waterValidate failed.
+int runScene(GLFWwindow* window)
+{
     Shader particleShader(NULL, "resources/shaders/wind/v_wind_particle.glsl", NULL, "resources/shaders/wind/f_wind_particle.glsl");
+    Shader particleGpuShader(NULL, "resources/shaders/wind/v_wind_particle_gpu.glsl", NULL, "resources/shaders/wind/f_wind_particle.glsl");
     Shader waterShader(NULL, "resources/shaders/water/grid.vs.glsl", NULL, "resources/shaders/water/grid.fs.glsl");
     Shader boatShader(NULL, "resources/shaders/assimp.v.glsl", NULL, "resources/shaders/assimp.f.glsl");
     Shader sunShader(NULL, "resources/shaders/sun/v_sun.glsl", NULL, "resources/shaders/sun/f_sun.glsl");
 	Shader islandShader(NULL, "resources/shaders/assimp.v.glsl", NULL, "resources/shaders/assimp.f.glsl");
     Shader waterHeightShader("resources/shaders/water/grid_height.cs.glsl", NULL, NULL, NULL);
     Shader waterNormalsShader("resources/shaders/water/grid_normals.cs.glsl", NULL, NULL, NULL);
+    Shader waterFusedShader("resources/shaders/water/grid_fused.cs.glsl", NULL, NULL, NULL);
+    Shader waterPatchShader(NULL, "resources/shaders/water/patch.vs.glsl", "resources/shaders/water/patch.tcs.glsl",
+                            "resources/shaders/water/patch.tes.glsl", NULL, "resources/shaders/water/grid.fs.glsl");
     Shader skyboxShader(NULL, "resources/shaders/skybox/skybox.vs.glsl", NULL, "resources/shaders/skybox/skybox.fs.glsl");
     Shader sharkShader(NULL, "resources/shaders/assimp.v.glsl", NULL, "resources/shaders/assimp.f.glsl");
 
-    Model sailboat("resources/models/sailboat/boat.obj");
-	Model island("resources/models/island/island.obj");
-    Model shark("resources/models/shark/shark.obj");
-
-    // particle mesh
-    float particle_square[] = {
-        0.0f, 1.0f, 0.0f,
-        1.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, 0.0f,
-
-        0.0f, 1.0f, 0.0f,
-        1.0f, 1.0f, 0.0f,
-        1.0f, 0.0f, 0.0f
-    };
-    SingleMesh particleMesh(particle_square, { 3 });
+    // models and textures are read on the loader's threads and uploaded a few per frame;
+    // the loader is declared after the models its uploads write into, so it goes first
+    Model sailboat;
+	Model island;
+    Model shark;
+    AssetLoader assetLoader;
+    TextureStreamer textureStreamer(assetLoader, streamTextures ? 4 : 0);
+    MemoryUsage memoryBeforeLoad = MemoryUsage::read();
+    bool assetsLoaded = false;
+    sailboat.loadAsync(assetLoader, textureStreamer, "resources/models/sailboat/boat.obj");
+    island.loadAsync(assetLoader, textureStreamer, "resources/models/island/island.obj");
+    shark.loadAsync(assetLoader, textureStreamer, "resources/models/shark/shark.obj");
+
+    OceanParams oceanParams;
+    oceanParams.windSpeed = windSpeed;
+    oceanParams.windDir = glm::normalize(glm::vec2(windDirection.x, windDirection.z));
+    OceanFFT ocean(oceanParams);
+
+    WindParticleParams windParticleParams;
+    windParticleParams.windDirection = windDirection;
+    windParticleParams.windSpeed = windSpeed;
+    windParticleParams.windWaveFrequency = windWaveFrequency;
+    windParticleParams.sideAmplitude = sideAmplitude;
+    windParticleParams.life = windParticleLife;
+    windParticleParams.spawnSeed = randomSeed + 1;
+    GpuParticleSystem gpuWindParticles(GpuParticleSystem::capacityFor(windGpuEmitter, windParticleParams.life), windParticleParams);
+    std::cout << "wind particles (CPU): " << ParticleSystem::kernelName(windParticles.kernel) << " update kernel" << std::endl;
+    if (particleBenchmark)
+        benchmarkParticleUpdate(windParticleParams);
+    unsigned int frameIndex = 0;
+
+    const char* waterComputeNames[] = { "two-pass", "fused", "analytic" };
+    GpuTimer waterComputeTimer(std::string("water compute (") + (waterTessellated ? "tessellated" : waterComputeNames[(int)waterCompute]) + ")");
+    const char* waterDrawModeNames[] = { "indexed", "index-free", "strip", "culled" };
+    GpuTimer waterDrawTimer(std::string("water draw (") + (waterTessellated ? "tessellated" : waterDrawModeNames[(int)waterDrawMode]) + ")");
+    GpuTimer particleSortTimer("wind particle sort (" + std::to_string(gpuWindParticles.capacity) + " slots, sorts the live ones)");
+
+    ParticleRenderer particleRenderer;
+    TransparencyPass transparencyPass(SCR_WIDTH, SCR_HEIGHT);
+    std::vector<ParticleInstance> particleInstances;
+
+    JobSystem jobs;
+    std::cout << "job system: " << jobs.threadCount() << " threads" << std::endl;
 
     // skybox
     float skyboxVertices[] =
@@ -199,62 +297,105 @@ int main()
         6, 2, 3
     };
 
-    // Generate vertices
-    for (int z = 0; z < waterGridRes; ++z) {
-        for (int x = 0; x < waterGridRes; ++x) {
-            float xpos = (float)x / (waterGridRes - 1) * waterGridSize - waterGridSize / 2.0f;
-            float zpos = (float)z / (waterGridRes - 1) * waterGridSize - waterGridSize / 2.0f;
-            waterVertices.emplace_back(glm::vec4(xpos, 0.0f, zpos, 0.0f)); // extra W=0.0
+    WaterClipmap waterClipmap(waterClipmapLevels, waterGridRes, waterGridSpacing, waterDrawMode);
+    std::cout << "water clipmap: " << waterClipmap.vertexCount() << " vertices (" << waterClipmap.vertexCount() * sizeof(WaterVertex) / 1024
+              << " KB), " << waterClipmap.triangleCount() << " triangles" << std::endl;
+    if (waterBenchmark)
+        waterClipmap.printDrawModeStats();
+    // tiles are culled with their bounds grown by the highest possible wave
+    float waterMaxHeight = waterUseFFT ? ocean.maxHeight() : 0.5f;
+
+    WaterPatchGrid waterPatchGrid(waterPatchesPerSide, waterPatchSize);
+    waterPatchGrid.maxWaveHeight = waterMaxHeight;
+
+    bool waterValid = true;
+    if (waterValidate) {
+        // one height pass per wave model at a fixed time, read back and compared with the CPU model
+        const float validateTime = 1.0f;
+        std::vector<glm::vec2> positions;
+        std::vector<float> heights;
+        std::vector<glm::vec3> normals;
+        for (unsigned int model = 0; model < 2; model++) {
+            if (model == 1) {
+                ocean.update(validateTime);
+                ocean.requestHeights();
+                std::vector<float> heightMap;
+                ocean.readHeights(heightMap, true);
+                waterHeightField.setHeightMap(heightMap, OceanFFT::FFT_SIZE, ocean.params.patchSize);
+            }
+            else
+                waterHeightField.setSineWave(validateTime);
+
+            waterHeightShader.use();
+            waterHeightShader.setFloat("time", validateTime);
+            waterHeightShader.setBool("analyticNormals", true);
+            waterClipmap.setUniforms(waterHeightShader);
+            if (model == 1)
+                ocean.bindHeightField(waterHeightShader);
+            else
+                waterHeightShader.setUInt("waveModel", 0);
+            waterClipmap.bindBuffers();
+            waterClipmap.dispatch();
+
+            waterClipmap.readVertices(positions, heights, normals);
+            waterValid = waterHeightField.compareWithGpu(positions, heights, normals, model == 1 ? "fft" : "sine") && waterValid;
         }
+        // no frames are drawn, the shutdown below still runs
+        if (!waterValid)
+            glfwSetWindowShouldClose(window, true);
     }
+    std::vector<float> waterHeightMap;
 
-    for (int z = 0; z < waterGridRes - 1; ++z) {
-        for (int x = 0; x < waterGridRes - 1; ++x) {
-            int topLeft = z * waterGridRes + x;
-            int topRight = topLeft + 1;
-            int bottomLeft = (z + 1) * waterGridRes + x;
-            int bottomRight = bottomLeft + 1;
-
-            // First triangle
-            waterIndices.push_back(topLeft);
-            waterIndices.push_back(bottomLeft);
-            waterIndices.push_back(topRight);
-
-            // Second triangle
-            waterIndices.push_back(topRight);
-            waterIndices.push_back(bottomLeft);
-            waterIndices.push_back(bottomRight);
+    // one fixed simulation step of the water at the given time
+    auto simulateWater = [&](float waterTime)
+    {
+        if (waterUseFFT) {
+            ocean.update(waterTime);
+            ocean.requestHeights();
         }
-    }
 
-    // -- Create and upload vertex positions to an SSBO --
-    GLuint waterVertSSBO;
-    glGenBuffers(1, &waterVertSSBO);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, waterVertSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, waterVertices.size() * sizeof(glm::vec4), waterVertices.data(), GL_DYNAMIC_DRAW);
-
-    // -- Create an SSBO for normals (optional / not used yet) --
-    GLuint waterNormSSBO;
-    glGenBuffers(1, &waterNormSSBO);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, waterNormSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, waterNormals.size() * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
-
-    // -- Bind the SSBOs to specific binding points so shaders can access them --
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, waterVertSSBO);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, waterNormSSBO); 
-
-    // -- Set up the VAO (used for element drawing) --
-    GLuint WaterVAO, WaterEBO;
-    glGenVertexArrays(1, &WaterVAO);
-    glGenBuffers(1, &WaterEBO);
-
-    glBindVertexArray(WaterVAO);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, WaterEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, waterIndices.size() * sizeof(unsigned int), waterIndices.data(), GL_STATIC_DRAW);
+        // the tessellated water samples the height field while drawing, nothing to precompute
+        if (!waterTessellated) {
+            waterClipmap.update(cameraPos);
+            waterClipmap.bindBuffers();
+            bool analyticNormals = waterCompute == WaterCompute::Analytic;
+
+            if (waterCompute == WaterCompute::Fused) {
+                waterFusedShader.use();
+                waterFusedShader.setFloat("time", waterTime);
+                waterClipmap.setUniforms(waterFusedShader);
+                if (waterUseFFT)
+                    ocean.bindHeightField(waterFusedShader);
+                else
+                    waterFusedShader.setUInt("waveModel", 0);
+                waterClipmap.dispatch();
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT); // ensure height and normal writes are done
+            }
+            else {
+                waterHeightShader.use();
+                waterHeightShader.setFloat("time", waterTime);
+                waterClipmap.setUniforms(waterHeightShader);
+                waterHeightShader.setBool("analyticNormals", analyticNormals);
+                if (waterUseFFT)
+                    ocean.bindHeightField(waterHeightShader);
+                else
+                    waterHeightShader.setUInt("waveModel", 0);
+                waterClipmap.dispatch();
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT); // ensure height writes are done
+
+                if (!analyticNormals) {
+                    waterNormalsShader.use();
+                    waterClipmap.setUniforms(waterNormalsShader);
+                    waterClipmap.dispatch();
+                    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT); // ensure normal writes are done
+                }
+            }
+        }
+    };
 
-    // -- No vertex attributes set up; vertex shader uses gl_VertexID to read from SSBO --
-    glBindVertexArray(0);
+    // fill both vertex buffers before the first frame
+    simulateWater(-simulationClock.stepLength());
+    simulateWater(0.0f);
 
     // Sun
 
@@ -279,17 +420,10 @@ int main()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load("resources/textures/sun/sunn.png", &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = nrChannels == 4 ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else {
-        std::cerr << "Failed to load sun texture!" << std::endl;
-    }
-    stbi_image_free(data);
+    assetLoader.load<TextureData>("sun texture", []() { return TextureCache::read("resources/textures/sun/sunn.png"); },
+        [&textureStreamer, sunTexture](TextureData& data) {
+            textureStreamer.stream(sunTexture, GL_TEXTURE_2D, std::move(data), false);
+        });
 
     // moon
 
@@ -314,17 +448,10 @@ int main()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int moonwidth, moonheight, moonnrChannels;
-    unsigned char* moondata = stbi_load("resources/textures/sun/moonn.png", &moonwidth, &moonheight, &moonnrChannels, 0);
-    if (moondata) {
-        GLenum moonformat = moonnrChannels == 4 ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, moonformat, moonwidth, moonheight, 0, moonformat, GL_UNSIGNED_BYTE, moondata);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else {
-        std::cerr << "Failed to load sun texture!" << std::endl;
-    }
-    stbi_image_free(moondata);
+    assetLoader.load<TextureData>("moon texture", []() { return TextureCache::read("resources/textures/sun/moonn.png"); },
+        [&textureStreamer, moonTexture](TextureData& data) {
+            textureStreamer.stream(moonTexture, GL_TEXTURE_2D, std::move(data), false);
+        });
 
     unsigned int squareVAO, squareVBO, squareEBO;
     glGenVertexArrays(1, &squareVAO);
@@ -381,43 +508,18 @@ int main()
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
+    // the faces decode in parallel and stream in over a few frames, the cubemap is black until all six are uploaded
     for (unsigned int i = 0; i < 6; i++) {
-        int width, height, nrChannels;
-        stbi_set_flip_vertically_on_load(false);
-        unsigned char* data = stbi_load(facesCubemap[i].c_str(), &width, &height, &nrChannels, 0);
-
-        if (!data) {
-            std::cerr << "Failed to load cubemap texture: " << facesCubemap[i] << std::endl;
-            continue;
-        }
-
-        GLenum format;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-        else {
-            std::cerr << "Unknown number of channels: " << nrChannels << " in " << facesCubemap[i] << std::endl;
-            stbi_image_free(data);
-            continue;
-        }
-
-        glTexImage2D(
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-            0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data
-        );
-
-        stbi_image_free(data);
+        std::string face = facesCubemap[i];
+        assetLoader.load<TextureData>(face, [face]() { return TextureCache::read(face); },
+            [&textureStreamer, cubemapTexture, i](TextureData& data) {
+                textureStreamer.stream(cubemapTexture, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, std::move(data), false);
+            });
     }
 
     skyboxShader.use();
     skyboxShader.setInt("skybox", 0);
 
-    for (unsigned int i = 0; i < windParticlesNumber; ++i)
-        windParticles.push_back(Particle());
-
     DirLight sunlight;
     sunlight.direction = glm::normalize(glm::vec3(-1.0f, -2.0f, -1.0f));
     sunlight.ambient = glm::vec3(0.2f, 0.2f, 0.2f);
@@ -456,18 +558,35 @@ int main()
     glm::mat4 boatMatrix = worldMatrix;
     boatMatrix = glm::scale(boatMatrix, glm::vec3(0.5f));
 
+    if (!asyncLoading) {
+        assetLoader.finish();
+        textureStreamer.finish();
+    }
+
     // render loop
     while (!glfwWindowShouldClose(window))
     {
-        // per-frame time logic
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        // per-frame time logic - real time is read once, the simulation runs in fixed steps
+        frameIndex++;
+        simulationClock.tick(glfwGetTime());
+        deltaTime = simulationClock.frameDelta();
+        float frameTime = (float)simulationClock.frameTime();
+        float simulationTime = (float)simulationClock.renderTime();
+        if (jobTrace && frameIndex == 100)
+            jobs.captureTrace("job_trace.json");
 
         // input
         processInput(window);
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
+        // models and textures that finished reading
+        bool uploaded = assetLoader.update(assetUploadBudget);
+        bool streamed = textureStreamer.update(textureStreamBudget);
+        if (uploaded && streamed && !assetsLoaded) {
+            assetsLoaded = true;
+            MemoryUsage::read().report("loading the models and textures", memoryBeforeLoad);
+        }
+
         // render
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -479,7 +598,7 @@ int main()
         // sun
         
         // compute sun position
-        float timeSeconds = glfwGetTime();
+        float timeSeconds = simulationTime;
         float angle = (timeSeconds / 20.0f) * 2.0f * glm::pi<float>();
         float radius = 90.0f, height = 30.0f;
 
@@ -552,7 +671,7 @@ int main()
 
         // wind
         float windBearing = glm::degrees(acos(glm::dot(glm::normalize(windDirection), glm::normalize(north)))); // wind direction in degrees where 0 or 360 is north
-        float largeWindAngle = sin(glfwGetTime() * windWaveFrequency) * largeScaleWindMaxAngle;
+        float largeWindAngle = sin(simulationTime * windWaveFrequency) * largeScaleWindMaxAngle;
         float largeWindAngleRad = glm::radians(largeWindAngle);
 
         glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), largeWindAngleRad, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -560,33 +679,32 @@ int main()
         glm::vec3 temp = glm::vec3(0.0f, 1.0f, 0.0f);
         largeWindDirection = glm::normalize(windDirection + (glm::normalize(glm::cross(windDirection, temp)) * (glm::length(windDirection) * sin(largeWindAngleRad))));
 
-        // spawning particles
-        if (compute_probability(windParticleSpawnProbability)) {
-            int unusedParticle = FirstUnusedWindParticle();
-            RespawnParticle(windParticles[unusedParticle]);
+        // spawning and updating particles
+        ParticleEmitter& emitter = windParticlesOnGpu ? windGpuEmitter : windEmitter;
+        unsigned int spawnCount = emitter.update(deltaTime, glm::length(cameraPos - boatPos));
+        emitter.reportStats(frameTime);
+        JobSystem::JobId particleJob = 0;
+        if (windParticlesOnGpu) {
+            gpuWindParticles.emit(spawnCount, boatPos);
+            gpuWindParticles.update(deltaTime, simulationTime);
         }
-        // update all particles
-
-        glm::vec3 sideAxis = glm::normalize(glm::cross(windDirection, glm::vec3(0.0f, 1.0f, 0.0f)));
-        for (unsigned int i = 0; i < windParticlesNumber; ++i)
-        {
-            Particle& p = windParticles[i];
-            p.Life -= deltaTime;
-            if (p.Life > 0.0f)
-            {
-                float windFactor = glfwGetTime() + p.Seed; // p.Seed is unique per particle
-                float sideOffset = sin(windFactor * windWaveFrequency) * sideAmplitude; // amplitude in units of distance
-                glm::vec3 offset = sideAxis * sideOffset;
-
-                glm::vec3 velocity = glm::normalize(windDirection + offset) * windSpeed;
-                p.Position += velocity * deltaTime;
-
-                if (p.Life < 1.0f)
-                    p.Color.a -= deltaTime * 2.5f;
-                else if (p.Life > windParticleLife - 1)
-                    if (p.Color.a < 1.0f - deltaTime * 2.5f)
-                        p.Color.a += deltaTime * 2.5f;
-            }
+        else {
+            windEmitter.spawn(windParticles, spawnCount, boatPos, windParticleParams);
+            // update the live particles on the job threads, then remove the dead ones and build the instances
+            JobSystem::JobId simulateJob = jobs.parallelFor("particles", 0, windParticles.aliveCount(), particleJobGrain,
+                [&](unsigned int begin, unsigned int end) {
+                    windParticles.simulate(windParticleParams, deltaTime, simulationTime, begin, end);
+                });
+            particleJob = jobs.add("particle instances", [&]() {
+                windParticles.compact();
+                particleInstances.clear();
+                for (unsigned int i = 0; i < windParticles.aliveCount(); ++i)
+                {
+                    float shade = windParticles.shade[i];
+                    particleInstances.push_back({ windParticles.position(i), windParticleParams.scale, glm::vec4(shade, shade, shade, windParticles.alpha[i]),
+                                                  windParticles.velocity(i, windParticleParams, simulationTime), 0.0f });
+                }
+            }, { simulateJob });
         }
         
         glm::vec3 nightTint = glm::vec3(0.1f, 0.1f, 0.2f);
@@ -607,68 +725,93 @@ int main()
 
         glDepthFunc(GL_LESS);
 
-        // water calculations
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, waterVertSSBO);
-
-        waterHeightShader.use();
-        waterHeightShader.setFloat("time", glfwGetTime());
-        waterHeightShader.setUInt("gridRes", waterGridRes);
-        int groupCount = (waterGridRes + 15) / 16; // rounds up
-        glDispatchCompute(groupCount, groupCount, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT); // ensure height writes are done
-
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, waterNormSSBO);
-
-        waterNormalsShader.use();
-        waterNormalsShader.setUInt("gridRes", waterGridRes);
-        glDispatchCompute(groupCount, groupCount, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT); // ensure normal writes are done
+        // water calculations - fixed steps, see SimulationClock
+        waterComputeTimer.begin();
+        while (simulationClock.step())
+            simulateWater((float)simulationClock.stepTime());
+        waterComputeTimer.end();
+        waterComputeTimer.report(frameTime);
+
+        // CPU side of the water for the boat
+        if (waterUseFFT) {
+            // an earlier step's heights, so reading them back never stalls; the
+            // field keeps the map and hands back its previous one for the next read
+            if (ocean.readHeights(waterHeightMap))
+                waterHeightField.setHeightMap(waterHeightMap, OceanFFT::FFT_SIZE, ocean.params.patchSize);
+        }
+        else
+            waterHeightField.setSineWave(simulationTime);
+
+        // model matrices, computed on the job threads while the water is drawn
+        glm::mat4 sharkMatrix, boatMatrixFloat;
+        JobSystem::JobId sharkJob = jobs.add("shark matrix", [&]() {
+            sharkMatrix = glm::mat4(1.0f);
+            sharkMatrix = glm::rotate(sharkMatrix, glm::radians(simulationTime * 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            sharkMatrix = glm::translate(sharkMatrix, glm::vec3(0.0f, 0.0f, 8.0f));
+            sharkMatrix = glm::translate(sharkMatrix, glm::vec3(0.0f, -1.0f, 0.0f));
+            sharkMatrix = glm::scale(sharkMatrix, glm::vec3(10.0f));
+        });
+        JobSystem::JobId boatJob = jobs.add("boat", [&]() {
+            // boat position for wind particles spawnpoint calculation
+            glm::mat4 boatFront = glm::translate(boatMatrix, glm::vec3(0.0f, 0.0f, 5.0f));
+            boatPos = glm::vec3(boatFront[3]);
+
+            // boat steering
+            glm::vec3 forward = glm::normalize(glm::vec3(boatMatrix[2]));
+            float windAlignment = glm::dot(forward, windDirection);
+
+            if (boatMove)
+                boatMatrix = glm::translate(boatMatrix, glm::vec3(0,0,MOVE_SPEED+windAlignment*0.008f)); // move boat forward
+
+            boatMatrix = glm::rotate(boatMatrix, glm::radians(boatRotate), glm::vec3(0.0f, 1.0f, 0.0f)); // rotate boat
+
+            boatMatrixFloat = glm::translate(boatMatrix, glm::vec3(0.0f, boatHeight(boatMatrix), 0.0f)); // boat floats on waves
+        });
 
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, waterVertSSBO);
-        
         // draw water
-        waterShader.use();
+        Shader& waterDrawShader = waterTessellated ? waterPatchShader : waterShader;
+        waterDrawShader.use();
         glm::mat4 waterModel = glm::mat4(1.0f);
-        waterShader.setMat4("view", view);
-        waterShader.setMat4("projection", projection);
-        waterShader.setMat4("model", waterModel);
-        waterShader.setVec3("sun.direction", sunlight.direction);
-        waterShader.setVec3("sun.ambient", sunlight.ambient);
-        waterShader.setVec3("sun.diffuse", sunlight.diffuse);
-        waterShader.setVec3("sun.specular", sunlight.specular);
-
-		waterShader.setVec3("moon.direction", moonlight.direction);
-		waterShader.setVec3("moon.ambient", moonlight.ambient);
-		waterShader.setVec3("moon.diffuse", moonlight.diffuse);
-		waterShader.setVec3("moon.specular", moonlight.specular);
-        waterShader.setFloat("time", glfwGetTime());
-        waterShader.setVec3("viewPos", cameraPos);
-        glBindVertexArray(WaterVAO);
+        waterDrawShader.setMat4("view", view);
+        waterDrawShader.setMat4("projection", projection);
+        waterDrawShader.setMat4("model", waterModel);
+        if (waterTessellated) {
+            waterPatchGrid.update(cameraPos);
+            waterPatchGrid.setUniforms(waterPatchShader, projection, view, (float)SCR_HEIGHT);
+            if (waterUseFFT)
+                ocean.bindHeightField(waterPatchShader);
+            else
+                waterPatchShader.setUInt("waveModel", 0);
+        }
+        else {
+            waterClipmap.setUniforms(waterShader);
+            waterClipmap.bindBuffers();
+        }
+        waterDrawShader.setVec3("sun.direction", sunlight.direction);
+        waterDrawShader.setVec3("sun.ambient", sunlight.ambient);
+        waterDrawShader.setVec3("sun.diffuse", sunlight.diffuse);
+        waterDrawShader.setVec3("sun.specular", sunlight.specular);
+
+		waterDrawShader.setVec3("moon.direction", moonlight.direction);
+		waterDrawShader.setVec3("moon.ambient", moonlight.ambient);
+		waterDrawShader.setVec3("moon.diffuse", moonlight.diffuse);
+		waterDrawShader.setVec3("moon.specular", moonlight.specular);
+        waterDrawShader.setFloat("time", simulationTime);
+        waterDrawShader.setFloat("interpolation", simulationClock.alpha());
+        waterDrawShader.setVec3("viewPos", cameraPos);
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        glDrawElements(GL_TRIANGLES, waterIndices.size(), GL_UNSIGNED_INT, 0);
-        //glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glBindVertexArray(0);
-
-        // draw particles
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        particleShader.use();
-        for (const Particle &particle : windParticles)
-        {
-            if (particle.Life > 0.0f)
-            {
-                particleShader.setMat4("view", view);
-                particleShader.setMat4("projection", projection);
-                particleShader.setVec3("sun.direction", sunlight.direction);
-                particleShader.setVec3("sun.ambient", sunlight.ambient);
-                glm::mat4 particleModel = glm::mat4(1.0f);
-                particleModel = glm::translate(particleModel, particle.Position);
-                particleModel = glm::scale(particleModel, glm::vec3(0.3f)); // size of particle
-                particleShader.setMat4("model", particleModel);
-                particleShader.setVec4("color", particle.Color);
-                particleMesh.Draw();
-            }
+        waterDrawTimer.begin();
+        if (waterTessellated)
+            waterPatchGrid.draw();
+        else {
+            waterClipmap.cull(projection * view * waterModel, waterMaxHeight);
+            waterShader.use();
+            waterClipmap.draw(waterShader);
         }
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        waterDrawTimer.end();
+        waterDrawTimer.report(frameTime);
+        waterClipmap.reportCullStats(frameTime);
+        //glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
         sharkShader.use();
         sharkShader.setVec3("sun.direction", sunlight.direction);
@@ -682,30 +825,11 @@ int main()
         sharkShader.setVec3("viewPos", cameraPos);
         sharkShader.setMat4("view", view);
         sharkShader.setMat4("projection", projection);
-        glm::mat4 sharkMatrix = glm::mat4(1.0f);
-        sharkMatrix = glm::rotate(sharkMatrix, glm::radians((float)glfwGetTime() * 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        sharkMatrix = glm::translate(sharkMatrix, glm::vec3(0.0f, 0.0f, 8.0f));
-        sharkMatrix = glm::translate(sharkMatrix, glm::vec3(0.0f, -1.0f, 0.0f));
-        sharkMatrix = glm::scale(sharkMatrix, glm::vec3(10.0f));
+        jobs.wait(sharkJob);
         sharkShader.setMat4("model", sharkMatrix);
         shark.Draw(sharkShader);
 
-        // boat position for wind particles spawnpoint calculation
-        glm::mat4 boatFront = glm::translate(boatMatrix, glm::vec3(0.0f, 0.0f, 5.0f));
-        boatPos = glm::vec3(boatFront[3]);
-        
-        // boat steering
-        glm::vec3 forward = glm::normalize(glm::vec3(boatMatrix[2]));
-        float windAlignment = glm::dot(forward, windDirection);
-
-        if (boatMove)
-            boatMatrix = glm::translate(boatMatrix, glm::vec3(0,0,MOVE_SPEED+windAlignment*0.008f)); // move boat forward
-
-        boatMatrix = glm::rotate(boatMatrix, glm::radians(boatRotate), glm::vec3(0.0f, 1.0f, 0.0f)); // rotate boat
-
-        glm::mat4 boatMatrixFloat = boatMatrix;
-        boatMatrixFloat = glm::translate(boatMatrix, glm::vec3(0.0f, boatHeight(boatMatrix), 0.0f)); // boat floats on waves
-
+        jobs.wait(boatJob);
         boatShader.use();
         boatShader.setVec3("sun.direction", sunlight.direction);
         boatShader.setVec3("sun.ambient", sunlight.ambient);
@@ -740,13 +864,62 @@ int main()
 		islandShader.setMat4("model", islandMatrix3);
 		island.Draw(islandShader);
 
+        // draw particles, translucent, after all opaque geometry
+        if (windParticlesOit) {
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            transparencyPass.begin(framebufferWidth, framebufferHeight);
+        }
+        if (windParticlesOnGpu) {
+            if (windParticlesSorted && !windParticlesOit) {
+                particleSortTimer.begin();
+                gpuWindParticles.sort(view);
+                particleSortTimer.end();
+                particleSortTimer.report(frameTime);
+            }
+            particleGpuShader.use();
+            particleGpuShader.setMat4("view", view);
+            particleGpuShader.setMat4("projection", projection);
+            particleGpuShader.setVec3("sun.direction", sunlight.direction);
+            particleGpuShader.setVec3("sun.ambient", sunlight.ambient);
+            particleGpuShader.setBool("velocityStreaks", windParticleStreaks);
+            particleGpuShader.setFloat("streakLength", windStreakLength);
+            particleGpuShader.setBool("weightedBlended", windParticlesOit);
+            gpuWindParticles.draw(particleGpuShader);
+            gpuWindParticles.reportStats(frameTime);
+        }
+        else {
+            jobs.wait(particleJob);
+            particleShader.use();
+            particleShader.setMat4("view", view);
+            particleShader.setMat4("projection", projection);
+            particleShader.setVec3("sun.direction", sunlight.direction);
+            particleShader.setVec3("sun.ambient", sunlight.ambient);
+            particleShader.setBool("velocityStreaks", windParticleStreaks);
+            particleShader.setFloat("streakLength", windStreakLength);
+            particleShader.setBool("weightedBlended", windParticlesOit);
+            particleRenderer.draw(particleInstances);
+            particleRenderer.reportStats(frameTime);
+            windParticles.reportStats(frameTime);
+        }
+        if (windParticlesOit)
+            transparencyPass.end();
+
+        // every job of the frame is done before the next one starts
+        jobs.waitFrame();
+        jobs.reportStats(frameTime);
+
         // check all events and swap the buffers
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    glfwTerminate();
-    return 0;
+    // Shutdown, in this order: no upload or copy may start after the loader
+    // stops, the streamer's mapped slots go once the copies into them are
+    // done, and the remaining GL objects go with the locals when this returns
+    assetLoader.shutdown();
+    textureStreamer.release();
+    return waterValid ? 0 : 1;
 }
 
 // ----------------------------------------------------------------
@@ -825,80 +998,62 @@ void processInput(GLFWwindow* window)
         boatMove = false;
 }
 
-// compute probability - used in spawning wind particles
-bool compute_probability(double probability) {
-    // Use the random number generator (random_device and mt19937)
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);  // Generates a random float between 0.0 and 1.0
-
-    // Generate a random number and compare it to the given probability
-    double random_value = dis(gen);
-    return random_value <= probability;
-}
-
-// ----------------------------------------------------------------
-
-unsigned int FirstUnusedWindParticle()
+// Times one update step of the array-of-structures Particle loop against every
+// ParticleSystem kernel the CPU supports, at 1k, 100k and 1M particles. The
+// particles live long enough to stay alive for the whole run, so every kernel
+// does the full work for every particle.
+void benchmarkParticleUpdate(const WindParticleParams& params)
 {
-    // search from last used particle, this will usually return almost instantly
-    for (unsigned int i = lastUsedWindParticle; i < windParticlesNumber; ++i) {
-        if (windParticles[i].Life <= 0.0f) {
-            lastUsedWindParticle = i;
-            return i;
+    typedef std::chrono::steady_clock Clock;
+    const float dt = 1.0f / 30.0f;
+    const unsigned int counts[] = { 1000, 100000, 1000000 };
+    RandomStream random(randomSeed, 1);
+
+    for (unsigned int count : counts) {
+        unsigned int steps = count >= 1000000 ? 20 : 20000000 / count;
+
+        std::vector<Particle> particles(count);
+        ParticleSystem system(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            glm::vec3 position(random.nextRange(-50.0f, 50.0f), random.nextRange(0.2f, 4.2f), random.nextRange(-50.0f, 50.0f));
+            float seed = random.nextRange(-1.0f * _Pi_val, 1.0f * _Pi_val);
+            particles[i].Position = position;
+            particles[i].Seed = seed;
+            particles[i].Life = 1e6f;
+            system.spawn(position, 0.85f, seed, 1e6f);
         }
-    }
-    // otherwise, do a linear search
-    for (unsigned int i = 0; i < lastUsedWindParticle; ++i) {
-        if (windParticles[i].Life <= 0.0f) {
-            lastUsedWindParticle = i;
-            return i;
+
+        // the loop ParticleSystem replaced
+        glm::vec3 sideAxis = glm::normalize(glm::cross(params.windDirection, glm::vec3(0.0f, 1.0f, 0.0f)));
+        Clock::time_point start = Clock::now();
+        for (unsigned int step = 0; step < steps; ++step) {
+            float time = step * dt;
+            for (Particle& p : particles) {
+                p.Life -= dt;
+                if (p.Life > 0.0f) {
+                    float sideOffset = sin((time + p.Seed) * params.windWaveFrequency) * params.sideAmplitude;
+                    glm::vec3 velocity = glm::normalize(params.windDirection + sideAxis * sideOffset) * params.windSpeed;
+                    p.Position += velocity * dt;
+                    if (p.Life < 1.0f)
+                        p.Color.a -= dt * 2.5f;
+                    else if (p.Life > params.life - 1)
+                        if (p.Color.a < 1.0f - dt * 2.5f)
+                            p.Color.a += dt * 2.5f;
+                }
+            }
         }
+        double baseline = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)steps * count);
+        std::cout << "particle update, " << count << " particles: AoS " << baseline << " ns/particle";
+
+        ParticleKernel best = ParticleSystem::bestKernel();
+        for (int k = (int)ParticleKernel::Scalar; k <= (int)best; ++k) {
+            system.kernel = (ParticleKernel)k;
+            start = Clock::now();
+            for (unsigned int step = 0; step < steps; ++step)
+                system.update(params, dt, step * dt);
+            double perParticle = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)steps * count);
+            std::cout << ", " << ParticleSystem::kernelName(system.kernel) << " " << perParticle << " ns (x" << baseline / perParticle << ")";
+        }
+        std::cout << std::endl;
     }
-    // override first particle if all others are alive
-    lastUsedWindParticle = 0;
-    return 0;
-}
-
-// ----------------------------------------------------------------
-
-// The particles are supposed to be spawned in a cylindrical area around the camera
-// but only in the half facing blowing wind (the side from which the wind blows)
-// they are supposed to be also spawned in certain distance from the camera and 
-// not in a way that would make them go into the camera
-void RespawnParticle(Particle& particle)
-{
-    float maxDistanceAgainstWind = 22.0f;
-    float minDistanceFromCamera = 8.0f;
-    float tunnelWidth = 14.0f;
-
-    float rColor = 0.8f + ((rand() % 100) / 1000.0f);
-    float particleHeight = getRandomFloat(0.2f, 4.2f);
-    float distanceAgainstWind = getRandomFloat(minDistanceFromCamera, maxDistanceAgainstWind); // maximum distance into the direction from which wind blows, also makes up the radius of circle around the camera 
-    float distanceToSide = getRandomFloat(-1.0f * (tunnelWidth / 2), tunnelWidth / 2);
-    
-    glm::vec3 againstWind = -glm::normalize(windDirection) * distanceAgainstWind;
-    glm::vec3 sideVec = glm::normalize(glm::cross(windDirection, glm::vec3(0.0f, 1.0f, 0.0f))) * distanceToSide; // right-hand rule
-    glm::vec3 sideOffset = sideVec * distanceToSide;
-    glm::vec3 offset = againstWind + sideOffset;
-    offset.y = particleHeight;
-    particle.Position = boatPos + offset; // should be: cameraPos + offset
-    //particle.Color = glm::vec4(rColor, rColor, rColor, 1.0f);
-    particle.Color = glm::vec4(rColor, rColor, rColor, 0.0f);
-    particle.Life = windParticleLife;
-    particle.Velocity = windDirection * 0.5f;
-    particle.Seed = getRandomFloat(-1.0f * _Pi_val, 1.0f * _Pi_val);
-}
-
-// ----------------------------------------------------------------
-
-float getRandomFloat(float min, float max) {
-    // Generate a random float between min and max
-    return min + (max - min) * (rand() / (float)RAND_MAX);
-}
-
-// ----------------------------------------------------------------
-
-float rand_normal() {
-    return distribution(generator);
 }
@@ -0,0 +1,99 @@
+// Checks that baked files stay valid when resources/ is copied next to the
+// executable, as the POST_BUILD step does: the copy gets new modification
+// times, and the app in the run directory must still hit the MeshCache and
+// TextureCache files baked in the source tree. Also checks that an edit of a
+// source of the same size is a miss. Exits non-zero when a check fails; run
+// by ctest.
+
+#include "MeshCache.h"
+#include "TextureCache.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok) {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+static const char* MODEL = "resources/models/triangle/triangle.obj";
+static const char* TEXTURE = "resources/textures/checker.ppm";
+
+static void writeFile(const std::string& path, const std::string& contents)
+{
+    fs::create_directories(fs::path(path).parent_path());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+}
+
+// a one-triangle model and a 2x2 RGB image, baked as asset_baker would
+static void bakeSourceTree()
+{
+    writeFile(MODEL, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+    writeFile(TEXTURE, std::string("P6\n2 2\n255\n") + std::string("\xff\x00\x00\x00\xff\x00\x00\x00\xff\xff\xff\xff", 12));
+
+    MeshData mesh;
+    mesh.vertices.resize(3);
+    mesh.vertices[1].Position = glm::vec3(1.0f, 0.0f, 0.0f);
+    mesh.vertices[2].Position = glm::vec3(0.0f, 1.0f, 0.0f);
+    mesh.indices = { 0, 1, 2 };
+    check(MeshCache::write(MODEL, MeshCache::POST_PROCESS, { mesh }), "the mesh cache is written");
+
+    std::string error;
+    check(TextureCache::bake(TEXTURE, error), "the texture is baked");
+}
+
+// what the app reads from the current directory, true for both from the cache
+static bool hitsCache()
+{
+    MappedFile meshFile;
+    std::vector<MeshView> views;
+    bool mesh = MeshCache::load(MODEL, MeshCache::POST_PROCESS, meshFile, views) && views.size() == 1 && views[0].indexCount == 3;
+    TextureData texture = TextureCache::read(TEXTURE, true);
+    return mesh && texture.file != nullptr && texture.levels.size() == 2;
+}
+
+int main()
+{
+    fs::path root = fs::temp_directory_path() / "asset_cache_test";
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    fs::create_directories(root / "source");
+    fs::create_directories(root / "run");
+
+    fs::current_path(root / "source");
+    bakeSourceTree();
+    check(hitsCache(), "the baked files are hit in the source tree");
+
+    // the copy next to the executable, every file an hour newer than its original
+    fs::copy(root / "source" / "resources", root / "run" / "resources", fs::copy_options::recursive);
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(root / "run" / "resources"))
+        if (entry.is_regular_file())
+            fs::last_write_time(entry.path(), fs::last_write_time(entry.path()) + std::chrono::hours(1));
+
+    fs::current_path(root / "run");
+    check(hitsCache(), "the baked files are hit in the run directory after the copy");
+
+    // same size, other contents
+    writeFile(MODEL, "v 0 0 0\nv 2 0 0\nv 0 1 0\nf 1 2 3\n");
+    MappedFile meshFile;
+    std::vector<MeshView> views;
+    check(!MeshCache::load(MODEL, MeshCache::POST_PROCESS, meshFile, views), "an edited model misses its cache");
+
+    fs::current_path(root);
+    fs::remove_all(root, ec);
+    if (failures == 0)
+        std::cout << "asset cache: all checks passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
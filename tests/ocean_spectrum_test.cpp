@@ -0,0 +1,108 @@
+// Checks the CPU reference of the FFT ocean (OceanSpectrum) against values
+// worked out by hand, so the GPU kernels that mirror it have a fixed point.
+// Exits non-zero when a check fails; run by ctest.
+
+#include "OceanSpectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok) {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+static bool near(double value, double expected, double tolerance = 1e-4)
+{
+    return std::abs(value - expected) <= tolerance * std::max(1.0, std::abs(expected));
+}
+
+// an 8x8 spectrum whose wave vectors are multiples of 0.1, wind 10 m/s along +x
+static OceanParams testParams()
+{
+    OceanParams params;
+    params.size = 8;
+    params.patchSize = 2.0f * glm::pi<float>() / 0.1f;
+    params.windSpeed = 10.0f;
+    params.windDir = glm::vec2(1.0f, 0.0f);
+    params.amplitude = 1.0f;
+    params.seed = 1337;
+    return params;
+}
+
+static void testPhillips(const OceanSpectrum& spectrum)
+{
+    // L = 10^2 / 9.81 = 10.1937, |k| = 0.1 along the wind:
+    // exp(-1 / (0.01 * L^2)) / 0.1^4 = exp(-0.96236) * 10^4 = 3819.9,
+    // the small-wave factor exp(-0.01 * (L / 1000)^2) is 1 - 1e-6
+    check(near(spectrum.phillips(glm::vec2(0.1f, 0.0f)), 3819.8955), "phillips along the wind");
+    // against the wind: the same times 0.07
+    check(near(spectrum.phillips(glm::vec2(-0.1f, 0.0f)), 267.39268), "phillips against the wind");
+    // across the wind (k.w = 0) and at k = 0 nothing
+    check(spectrum.phillips(glm::vec2(0.0f, 0.1f)) == 0.0f, "phillips across the wind");
+    check(spectrum.phillips(glm::vec2(0.0f, 0.0f)) == 0.0f, "phillips at k = 0");
+    // k = (0.2, 0.1): k^2 = 0.05, (k.w)^2 / k^2 = 0.8
+    // exp(-1 / (0.05 * L^2)) / 0.05^2 * 0.8 = 263.97
+    check(near(spectrum.phillips(glm::vec2(0.2f, 0.1f)), 263.97215), "phillips off the wind axis");
+    check(near(OceanSpectrum::dispersion(glm::vec2(0.3f, 0.4f)), std::sqrt(9.81 * 0.5)), "dispersion");
+}
+
+static void testSpectrum(const OceanSpectrum& spectrum)
+{
+    unsigned int N = spectrum.params.size;
+    check(spectrum.h0.size() == N * N && spectrum.h0MinusConj.size() == N * N, "spectrum size");
+
+    // k = (0.1, 0) is n = 5, m = 4; pcgHash of seed 1337 gives the Box-Muller
+    // pair (0.174412, 1.114766) for index 37, times sqrt(3819.8955 / 2)
+    check(spectrum.waveVector(5, 4).x > 0.0999f && spectrum.waveVector(5, 4).x < 0.1001f, "wave vector of n = 5");
+    OceanSpectrum::complex h = spectrum.h0[4 * N + 5];
+    check(near(h.real(), 7.622337) && near(h.imag(), 48.718567), "h0(k) of index 37");
+    check(spectrum.h0[4 * N + 4] == OceanSpectrum::complex(0.0f), "h0(0) is zero");
+
+    // conj(h0(-k)) is stored for every k; away from the Nyquist row and
+    // column -k is another entry of h0, so the two tables must agree exactly
+    bool hermitian = true;
+    for (unsigned int m = 1; m < N; m++)
+        for (unsigned int n = 1; n < N; n++)
+            hermitian = hermitian && spectrum.h0MinusConj[m * N + n] == std::conj(spectrum.h0[(N - m) * N + (N - n)]);
+    check(hermitian, "h0MinusConj(k) == conj(h0(-k))");
+}
+
+static void testInverseFFT()
+{
+    // against the direct sum x_j = sum_k X_k e^(2 pi i jk / N), unnormalized
+    const unsigned int N = 8;
+    std::vector<OceanSpectrum::complex> line(N), direct(N);
+    for (unsigned int k = 0; k < N; k++)
+        line[k] = OceanSpectrum::complex((float)k - 3.0f, 0.5f * (float)(k * k % 5));
+    for (unsigned int j = 0; j < N; j++) {
+        std::complex<double> sum = 0.0;
+        for (unsigned int k = 0; k < N; k++)
+            sum += std::complex<double>(line[k]) * std::polar(1.0, 2.0 * 3.14159265358979 * j * k / N);
+        direct[j] = OceanSpectrum::complex(sum);
+    }
+    OceanSpectrum::inverseFFT(line);
+    bool same = true;
+    for (unsigned int j = 0; j < N; j++)
+        same = same && near(line[j].real(), direct[j].real(), 1e-5) && near(line[j].imag(), direct[j].imag(), 1e-5);
+    check(same, "inverse FFT matches the direct sum");
+}
+
+int main()
+{
+    OceanSpectrum spectrum(testParams());
+    testPhillips(spectrum);
+    testSpectrum(spectrum);
+    testInverseFFT();
+    if (failures == 0)
+        std::cout << "ocean spectrum: all checks passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
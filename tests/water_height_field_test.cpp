@@ -0,0 +1,135 @@
+// Checks WaterHeightField on the CPU: the four-wide SSE2 path of query()
+// against its scalar path and against the formulas it mirrors, the sine wave
+// of wave.glsl and the bilinear FFT lookup of OceanSpectrum::sample(). The
+// counts are not multiples of 4, so the scalar tail runs after the batch.
+// Exits non-zero when a check fails; run by ctest.
+
+#include "WaterHeightField.h"
+#include "OceanSpectrum.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what)
+{
+    if (!ok) {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+static bool near(double value, double expected, double tolerance)
+{
+    return std::abs(value - expected) <= tolerance * std::max(1.0, std::abs(expected));
+}
+
+// positions across several FFT tiles, negative ones included for the floor
+static void positions(unsigned int count, std::vector<float>& x, std::vector<float>& z)
+{
+    x.resize(count);
+    z.resize(count);
+    for (unsigned int i = 0; i < count; i++) {
+        RandomStream random(7, i);
+        x[i] = random.nextRange(-300.0f, 300.0f);
+        z[i] = random.nextRange(-300.0f, 300.0f);
+    }
+}
+
+// query() of count points in one batch against one point at a time, which
+// never reaches the four-wide path
+static void testBatchMatchesScalar(const WaterHeightField& field, const char* model)
+{
+    for (unsigned int count : { 1u, 3u, 5u, 7u, 13u, 130u }) {
+        std::vector<float> x, z;
+        positions(count, x, z);
+        std::vector<float> heights(count);
+        std::vector<glm::vec3> normals(count);
+        field.query(x.data(), z.data(), count, heights.data(), normals.data());
+
+        bool same = true;
+        for (unsigned int i = 0; i < count; i++) {
+            float h;
+            glm::vec3 n;
+            field.query(&x[i], &z[i], 1, &h, &n);
+            same = same && near(heights[i], h, 1e-5) && glm::length(normals[i] - n) < 1e-4f;
+        }
+        check(same, std::string(model) + ": batch of " + std::to_string(count) + " matches the scalar path");
+    }
+}
+
+// sineWaveHeightAndGradient in wave.glsl, written out with std::sin
+static void testSine()
+{
+    const float time = 1.7f;
+    WaterHeightField field;
+    field.setSineWave(time);
+    testBatchMatchesScalar(field, "sine");
+
+    const unsigned int count = 37;
+    std::vector<float> x, z;
+    positions(count, x, z);
+    std::vector<float> heights(count);
+    std::vector<glm::vec3> normals(count);
+    field.query(x.data(), z.data(), count, heights.data(), normals.data());
+
+    const float f = WaterHeightField::SINE_FREQ, a = WaterHeightField::SINE_AMP;
+    bool heightsMatch = true, normalsMatch = true;
+    for (unsigned int i = 0; i < count; i++) {
+        float sx = std::sin(x[i] * f + time), cx = std::cos(x[i] * f + time);
+        float sz = std::sin(z[i] * f + time), cz = std::cos(z[i] * f + time);
+        glm::vec3 normal = glm::normalize(glm::vec3(-cx * cz * f * a, 1.0f, sx * sz * f * a));
+        heightsMatch = heightsMatch && near(heights[i], sx * cz * a, 1e-5);
+        normalsMatch = normalsMatch && glm::length(normals[i] - normal) < 1e-4f;
+    }
+    check(heightsMatch, "sine: heights match wave.glsl");
+    check(normalsMatch, "sine: normals match wave.glsl");
+}
+
+// a 16x16 spectrum on a ~63 m tile, wind 10 m/s along +x
+static void testFFT()
+{
+    OceanParams params;
+    params.size = 16;
+    params.patchSize = 2.0f * glm::pi<float>() / 0.1f;
+    params.windSpeed = 10.0f;
+    params.windDir = glm::vec2(1.0f, 0.0f);
+    params.amplitude = 1.0f;
+    OceanSpectrum spectrum(params);
+    std::vector<float> heightMap = spectrum.heights(1.0f);
+
+    float highest = 0.0f;
+    for (float h : heightMap)
+        highest = std::max(highest, std::abs(h));
+    check(highest > 1e-3f, "fft: the height map has waves");
+
+    WaterHeightField field;
+    std::vector<float> swapped = heightMap;
+    field.setHeightMap(swapped, params.size, params.patchSize);
+    testBatchMatchesScalar(field, "fft");
+
+    const unsigned int count = 37;
+    std::vector<float> x, z;
+    positions(count, x, z);
+    std::vector<float> heights(count);
+    field.query(x.data(), z.data(), count, heights.data());
+
+    bool same = true;
+    for (unsigned int i = 0; i < count; i++)
+        same = same && std::abs(heights[i] - spectrum.sample(heightMap, x[i], z[i])) <= 1e-5 * std::max(1.0f, highest);
+    check(same, "fft: heights match OceanSpectrum::sample");
+}
+
+int main()
+{
+    testSine();
+    testFFT();
+    if (failures == 0)
+        std::cout << "water height field: all checks passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// asset_baker - bakes resources/ into resources/baked/ ahead of time
+//
+//     asset_baker [project directory] [--force]
+//
+// Models (.obj, .fbx) go through the same MeshCache::import the app runs and
+// are written as MeshCache files, images (.png, .jpg) are decoded and
+// mipmapped into TextureCache files. An asset whose baked file is current is
+// skipped unless --force is given, so a second run only bakes what changed.
+// The assets are baked in parallel on a JobSystem. Run it from the directory
+// that holds resources/, or pass that directory.
+
+#include "MeshCache.h"
+#include "TextureCache.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+enum class AssetType {
+    Model,
+    Texture
+};
+
+struct Asset {
+    std::string path; // relative to the project directory, with / like the app uses
+    AssetType type;
+    std::string result;
+    bool failed = false;
+};
+
+static bool hasExtension(const fs::path& path, std::initializer_list<const char*> extensions)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    for (const char* candidate : extensions)
+        if (extension == candidate)
+            return true;
+    return false;
+}
+
+static void bake(Asset& asset, bool force)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string error;
+    if (asset.type == AssetType::Model) {
+        if (!force && MeshCache::isCurrent(asset.path, MeshCache::POST_PROCESS)) {
+            asset.result = "up to date";
+            return;
+        }
+        std::vector<MeshData> meshes;
+        if (!MeshCache::import(asset.path, MeshCache::POST_PROCESS, meshes, error))
+            asset.failed = true;
+        else if (!MeshCache::write(asset.path, MeshCache::POST_PROCESS, meshes)) {
+            error = "cannot write " + MeshCache::cachePath(asset.path);
+            asset.failed = true;
+        }
+    }
+    else {
+        if (!force && TextureCache::isCurrent(asset.path)) {
+            asset.result = "up to date";
+            return;
+        }
+        asset.failed = !TextureCache::bake(asset.path, error);
+    }
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    asset.result = asset.failed ? "FAILED: " + error : "baked in " + std::to_string((int)milliseconds) + " ms";
+}
+
+int main(int argc, char** argv)
+{
+    bool force = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--force") == 0)
+            force = true;
+        else {
+            std::error_code ec;
+            fs::current_path(argv[i], ec);
+            if (ec) {
+                std::cout << "ERROR::ASSET_BAKER::NO_DIRECTORY: " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (!fs::is_directory(AssetCache::SOURCE_DIRECTORY)) {
+        std::cout << "ERROR::ASSET_BAKER::NO_RESOURCES: run in the directory that holds " << AssetCache::SOURCE_DIRECTORY << std::endl;
+        return 1;
+    }
+
+    std::vector<Asset> assets;
+    fs::path bakeDirectory = fs::path(AssetCache::BAKE_DIRECTORY).lexically_normal();
+    for (fs::recursive_directory_iterator it(AssetCache::SOURCE_DIRECTORY), end; it != end; ++it) {
+        if (it->is_directory() && it->path().lexically_normal() == bakeDirectory) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file())
+            continue;
+        Asset asset;
+        asset.path = it->path().generic_string();
+        if (hasExtension(it->path(), { ".obj", ".fbx" }))
+            asset.type = AssetType::Model;
+        else if (hasExtension(it->path(), { ".png", ".jpg", ".jpeg" }))
+            asset.type = AssetType::Texture;
+        else
+            continue;
+        assets.push_back(asset);
+    }
+    // the biggest first, so the long bakes don't end up last on one thread
+    std::sort(assets.begin(), assets.end(), [](const Asset& a, const Asset& b) {
+        return fs::file_size(a.path) > fs::file_size(b.path);
+    });
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    JobSystem jobs;
+    JobSystem::JobId all = jobs.parallelFor("bake", 0, (unsigned int)assets.size(), 1, [&](unsigned int first, unsigned int last) {
+        for (unsigned int i = first; i < last; i++)
+            bake(assets[i], force);
+    });
+    jobs.wait(all);
+    jobs.waitFrame();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int failed = 0;
+    for (const Asset& asset : assets) {
+        std::cout << asset.path << ": " << asset.result << std::endl;
+        failed += asset.failed ? 1 : 0;
+    }
+    std::cout << assets.size() << " assets, " << failed << " failed, " << seconds << " s on " << jobs.threadCount() << " threads" << std::endl;
+    return failed == 0 ? 0 : 1;
+}